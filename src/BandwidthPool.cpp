@@ -0,0 +1,85 @@
+#include "BandwidthPool.hpp"
+#include <algorithm>
+
+BandwidthPool::BandwidthPool(double totalBandwidth, double perDirectoryCap)
+    : totalBandwidth(totalBandwidth), perDirectoryCap(perDirectoryCap),
+      virtualWork(0.0), nextHandle(1)
+{
+}
+
+int BandwidthPool::start(double work)
+{
+    int handle = nextHandle++;
+    double finishWork = virtualWork + work;
+    transfers[handle] = Transfer{finishWork, false};
+    finishOrder.emplace(finishWork, handle);
+    return handle;
+}
+
+void BandwidthPool::cancel(int handle)
+{
+    auto it = transfers.find(handle);
+    if (it == transfers.end()) {
+        return;
+    }
+
+    if (!it->second.finished) {
+        finishOrder.erase(std::make_pair(it->second.finishWork, handle));
+    }
+    transfers.erase(it);
+}
+
+void BandwidthPool::release(int handle)
+{
+    cancel(handle);
+}
+
+void BandwidthPool::advance(double deltaTime)
+{
+    while (deltaTime > 0.0 && !finishOrder.empty()) {
+        double rate = getRate();
+        if (rate <= 0.0) {
+            return;
+        }
+
+        auto next = finishOrder.begin();
+        double timeToFinish = (next->first - virtualWork) / rate;
+        if (timeToFinish > deltaTime) {
+            virtualWork += rate * deltaTime;
+            return;
+        }
+
+        deltaTime -= std::max(0.0, timeToFinish);
+        virtualWork = std::max(virtualWork, next->first);
+        transfers[next->second].finished = true;
+        finishOrder.erase(next);
+    }
+}
+
+bool BandwidthPool::isFinished(int handle) const
+{
+    auto it = transfers.find(handle);
+    return it != transfers.end() && it->second.finished;
+}
+
+double BandwidthPool::getRemainingWork(int handle) const
+{
+    auto it = transfers.find(handle);
+    if (it == transfers.end() || it->second.finished) {
+        return 0.0;
+    }
+    return std::max(0.0, it->second.finishWork - virtualWork);
+}
+
+double BandwidthPool::getRate() const
+{
+    if (finishOrder.empty()) {
+        return std::min(perDirectoryCap, totalBandwidth);
+    }
+    return std::min(perDirectoryCap, totalBandwidth / finishOrder.size());
+}
+
+int BandwidthPool::getActiveCount() const
+{
+    return static_cast<int>(finishOrder.size());
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Processor-sharing model of a bandwidth resource shared by several
+// directories. Every active transfer gets min(perDirectoryCap, total / n),
+// so they all progress at the same rate. Progress is tracked as "virtual
+// work": the work each active transfer has received since the pool was
+// created. A transfer then finishes when virtual work reaches its start
+// value plus its size, which stays fixed when the rate changes. Starting,
+// cancelling and finishing a transfer are therefore O(log n), with no
+// sweep over the other transfers.
+class BandwidthPool
+{
+public:
+    BandwidthPool(double totalBandwidth, double perDirectoryCap);
+
+    int start(double work);
+    void cancel(int handle);
+    void release(int handle);
+
+    // Advances by deltaTime seconds, handling every finish inside the
+    // interval at its exact time with the rate recomputed after each one
+    void advance(double deltaTime);
+
+    bool isFinished(int handle) const;
+    double getRemainingWork(int handle) const;
+    double getRate() const;
+    int getActiveCount() const;
+
+private:
+    struct Transfer
+    {
+        double finishWork;
+        bool finished;
+    };
+
+    double totalBandwidth;
+    double perDirectoryCap;
+    double virtualWork;
+    int nextHandle;
+    std::set<std::pair<double, int>> finishOrder;
+    std::unordered_map<int, Transfer> transfers;
+};
+
+// Shared-bandwidth settings. Directories are spread round-robin over
+// poolCount independent pools. A chain of resources that every transfer
+// crosses (for example a disk array and then an uplink) behaves like its
+// narrowest link, so configure it as that one pool.
+struct BandwidthConfig
+{
+    bool enabled = false;
+    int poolCount = 1;
+    double poolBandwidth = 50.0;
+    double perDirectoryCap = 10.0;
+};
@@ -0,0 +1,169 @@
+#include "CapacityTuner.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+CapacityTuner::CapacityTuner(const Config& config)
+    : config(config)
+{
+    this->config.maxDirectories = std::max(1, config.maxDirectories);
+    this->config.replications = std::max(1, config.replications);
+    this->config.parallelRuns = std::max(1, config.parallelRuns);
+}
+
+CapacityTuner::Result CapacityTuner::run()
+{
+    auto result = Result{};
+    result.found = false;
+
+    for (auto policy : config.policies)
+    {
+        if (!evaluate(policy, config.maxDirectories).meetsSlo)
+        {
+            continue;
+        }
+
+        // Bisection over [1, maxDirectories]; assumes the percentile does not
+        // grow as directories are added
+        int low = 1;
+        int high = config.maxDirectories;
+        while (low < high)
+        {
+            int middle = low + (high - low) / 2;
+            if (evaluate(policy, middle).meetsSlo)
+            {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+
+        const auto& candidate = evaluate(policy, high);
+        if (!result.found ||
+            candidate.directoryCount < result.best.directoryCount ||
+            (candidate.directoryCount == result.best.directoryCount &&
+             candidate.meanPercentile < result.best.meanPercentile))
+        {
+            result.best = candidate;
+            result.found = true;
+        }
+    }
+
+    result.evaluated = evaluationOrder;
+    return result;
+}
+
+const CapacityTuner::Point& CapacityTuner::evaluate(SchedulingMode policy, int directoryCount)
+{
+    auto key = std::make_pair(policy, directoryCount);
+    auto cached = cache.find(key);
+    if (cached != cache.end())
+    {
+        return cached->second;
+    }
+
+    // Replications run in batches of parallelRuns threads
+    auto samples = std::vector<double>(config.replications, 0.0);
+    for (int first = 0; first < config.replications; first += config.parallelRuns)
+    {
+        int last = std::min(config.replications, first + config.parallelRuns);
+        auto workers = std::vector<std::thread>{};
+        for (int i = first; i < last; i++)
+        {
+            workers.emplace_back([this, &samples, policy, directoryCount, i]()
+                {
+                    samples[i] = runReplication(policy, directoryCount, config.seed + static_cast<unsigned int>(i));
+                });
+        }
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    double mean = 0.0;
+    for (double sample : samples)
+    {
+        mean += sample;
+    }
+    mean /= samples.size();
+
+    double standardError = 0.0;
+    if (samples.size() > 1)
+    {
+        double variance = 0.0;
+        for (double sample : samples)
+        {
+            variance += (sample - mean) * (sample - mean);
+        }
+        variance /= samples.size() - 1;
+        standardError = std::sqrt(variance / samples.size());
+    }
+
+    int degreesOfFreedom = static_cast<int>(samples.size()) - 1;
+    double halfWidth = tQuantileTwoSided95(degreesOfFreedom) * standardError;
+    double sloBound = mean + tQuantileOneSided95(degreesOfFreedom) * standardError;
+    auto point = Point{policy, directoryCount, mean, mean - halfWidth, mean + halfWidth, sloBound,
+        sloBound <= config.sloSeconds};
+    evaluationOrder.push_back(point);
+    return cache.emplace(key, point).first->second;
+}
+
+double CapacityTuner::runReplication(SchedulingMode policy, int directoryCount, unsigned int seed) const
+{
+    auto simulation = Simulation{directoryCount};
+    simulation.setSeed(seed);
+    simulation.setSchedulingMode(policy);
+    simulation.setWorkloadSpec(config.workload);
+    simulation.setBandwidthConfig(config.bandwidth);
+    simulation.setPipeline(config.pipeline);
+    simulation.setDedupConfig(config.dedup);
+    simulation.setSteadyStateConfig(config.steadyState);
+    simulation.setCustomerBehavior(config.behavior);
+    if (!config.tracePath.empty())
+    {
+        // A candidate that cannot replay the workload never meets the SLO
+        auto error = std::string{};
+        if (!simulation.setTraceReplay(config.tracePath, error))
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+    }
+    simulation.initialize(config.customerCount);
+
+    while (!simulation.allFilesProcessed() && !simulation.reachedSteadyState())
+    {
+        simulation.step();
+    }
+
+    return simulation.getSteadyStateWaitPercentile(config.sloPercentile);
+}
+
+double CapacityTuner::tQuantileOneSided95(int degreesOfFreedom)
+{
+    // One-sided 95% quantiles of Student's t distribution
+    static const double table[] = {
+        6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812,
+        1.796, 1.782, 1.771, 1.761, 1.753, 1.746, 1.740, 1.734, 1.729, 1.725
+    };
+
+    if (degreesOfFreedom <= 0) return 0.0;
+    if (degreesOfFreedom <= 20) return table[degreesOfFreedom - 1];
+    if (degreesOfFreedom <= 30) return 1.70;
+    return 1.645;
+}
+
+double CapacityTuner::tQuantileTwoSided95(int degreesOfFreedom)
+{
+    // Two-sided 95% (one-sided 97.5%) quantiles of Student's t distribution
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086
+    };
+
+    if (degreesOfFreedom <= 0) return 0.0;
+    if (degreesOfFreedom <= 20) return table[degreesOfFreedom - 1];
+    if (degreesOfFreedom <= 30) return 2.06;
+    return 1.96;
+}
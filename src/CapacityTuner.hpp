@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "WorkloadSpec.hpp"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Searches for the smallest directory count whose wait-time percentile meets
+// an SLO. Every candidate is run for several seeded replications in
+// parallel, and it only counts as meeting the SLO when the one-sided 95%
+// upper confidence bound on the percentile is within it. The reported
+// interval is a separate, two-sided 95% one.
+//
+// With steady-state detection on, the percentile leaves out the completions
+// MSER marks as warm-up, so it describes the steady state. Without it, it
+// covers the whole run, transient included. Warm state is not carried
+// between runs: it depends on the directory count, session coroutines
+// cannot be copied, and branching replications off one warm-up would
+// correlate them and invalidate the interval.
+class CapacityTuner
+{
+public:
+    struct Config
+    {
+        WorkloadSpec workload;
+        BandwidthConfig bandwidth;
+        PipelineConfig pipeline;
+        DedupConfig dedup;
+        SteadyStateConfig steadyState;
+        CustomerBehavior behavior;
+        // Replayed instead of generated customers when set
+        std::string tracePath;
+        int customerCount = 100;
+        double sloPercentile = 0.99;
+        double sloSeconds = 60.0;
+        int maxDirectories = 64;
+        int replications = 5;
+        int parallelRuns = 1;
+        unsigned int seed = 1;
+        std::vector<SchedulingMode> policies = {SchedulingMode::CentralGreedy, SchedulingMode::WorkStealing};
+    };
+
+    struct Point
+    {
+        SchedulingMode policy;
+        int directoryCount;
+        double meanPercentile;
+        // Two-sided 95% confidence interval
+        double lowerBound;
+        double upperBound;
+        // One-sided 95% upper bound, compared against the SLO
+        double sloBound;
+        bool meetsSlo;
+    };
+
+    struct Result
+    {
+        bool found;
+        Point best;
+        std::vector<Point> evaluated;
+    };
+
+    CapacityTuner(const Config& config);
+
+    Result run();
+
+private:
+    const Point& evaluate(SchedulingMode policy, int directoryCount);
+    double runReplication(SchedulingMode policy, int directoryCount, unsigned int seed) const;
+    static double tQuantileOneSided95(int degreesOfFreedom);
+    static double tQuantileTwoSided95(int degreesOfFreedom);
+
+    Config config;
+    // Evaluated points are memoised so the search never reruns a candidate
+    std::map<std::pair<SchedulingMode, int>, Point> cache;
+    std::vector<Point> evaluationOrder;
+};
@@ -0,0 +1,127 @@
+#include "Crc32c.hpp"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define FTS_CRC32C_SSE42 1
+#else
+#define FTS_CRC32C_SSE42 0
+#endif
+
+namespace
+{
+    constexpr std::uint32_t Polynomial = 0x82F63B78u;
+
+    using Table = std::array<std::array<std::uint32_t, 256>, 8>;
+
+    constexpr Table makeTable()
+    {
+        auto table = Table{};
+        for (std::uint32_t i = 0; i < 256; i++) {
+            auto crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ Polynomial : crc >> 1;
+            }
+            table[0][i] = crc;
+        }
+        for (std::uint32_t i = 0; i < 256; i++) {
+            for (int slice = 1; slice < 8; slice++) {
+                table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+            }
+        }
+        return table;
+    }
+
+    constexpr Table CrcTable = makeTable();
+
+    std::uint32_t crc32cPortable(std::uint32_t crc, const unsigned char* data, std::size_t size)
+    {
+        while (size > 0 && (reinterpret_cast<std::uintptr_t>(data) & 7) != 0) {
+            crc = (crc >> 8) ^ CrcTable[0][(crc ^ *data++) & 0xFF];
+            size--;
+        }
+
+        // Slicing-by-8 assumes a little-endian load
+        while (size >= 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            word ^= crc;
+            crc = CrcTable[7][word & 0xFF] ^
+                  CrcTable[6][(word >> 8) & 0xFF] ^
+                  CrcTable[5][(word >> 16) & 0xFF] ^
+                  CrcTable[4][(word >> 24) & 0xFF] ^
+                  CrcTable[3][(word >> 32) & 0xFF] ^
+                  CrcTable[2][(word >> 40) & 0xFF] ^
+                  CrcTable[1][(word >> 48) & 0xFF] ^
+                  CrcTable[0][word >> 56];
+            data += 8;
+            size -= 8;
+        }
+
+        while (size > 0) {
+            crc = (crc >> 8) ^ CrcTable[0][(crc ^ *data++) & 0xFF];
+            size--;
+        }
+        return crc;
+    }
+
+#if FTS_CRC32C_SSE42
+    __attribute__((target("sse4.2")))
+    std::uint32_t crc32cHardware(std::uint32_t crc, const unsigned char* data, std::size_t size)
+    {
+        while (size > 0 && (reinterpret_cast<std::uintptr_t>(data) & 7) != 0) {
+            crc = _mm_crc32_u8(crc, *data++);
+            size--;
+        }
+
+        std::uint64_t wide = crc;
+        while (size >= 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            wide = _mm_crc32_u64(wide, word);
+            data += 8;
+            size -= 8;
+        }
+        crc = static_cast<std::uint32_t>(wide);
+
+        while (size > 0) {
+            crc = _mm_crc32_u8(crc, *data++);
+            size--;
+        }
+        return crc;
+    }
+#endif
+
+    using Implementation = std::uint32_t (*)(std::uint32_t, const unsigned char*, std::size_t);
+
+    Implementation selectImplementation()
+    {
+#if FTS_CRC32C_SSE42
+        if (__builtin_cpu_supports("sse4.2")) {
+            return crc32cHardware;
+        }
+#endif
+        return crc32cPortable;
+    }
+
+    Implementation implementation()
+    {
+        static const auto selected = selectImplementation();
+        return selected;
+    }
+}
+
+std::uint32_t crc32c(std::uint32_t crc, const void* data, std::size_t size)
+{
+    return ~implementation()(~crc, static_cast<const unsigned char*>(data), size);
+}
+
+bool crc32cHardwareAccelerated()
+{
+#if FTS_CRC32C_SSE42
+    return implementation() != crc32cPortable;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC32C (Castagnoli). Uses the SSE4.2 crc32 instruction when the CPU has
+// it and a slicing-by-8 table otherwise; the choice is made once, at the
+// first call. Pass the previous result as crc to continue a stream; start
+// with 0.
+std::uint32_t crc32c(std::uint32_t crc, const void* data, std::size_t size);
+
+bool crc32cHardwareAccelerated();
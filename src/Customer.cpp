@@ -20,9 +20,10 @@ Customer::~Customer()
     processedFiles.clear();
 }
 
-void Customer::addFile(int size)
+void Customer::addFile(int size, std::uint64_t contentKey)
 {
     pendingFiles.push_back(new File(0, size));
+    pendingFiles.back()->setContentKey(contentKey);
     std::sort(pendingFiles.begin(), pendingFiles.end(), [](const File* a, const File* b) {
         return a->getSize() < b->getSize();
     });
@@ -38,6 +39,18 @@ void Customer::addFile(File* file)
     pendingFiles.insert(pendingFiles.begin(), file);
 }
 
+File* Customer::submitFile(int size)
+{
+    // Unlike addFile(int), ids of files already queued stay stable so that
+    // scripts can keep waiting on them
+    auto file = new File(++fileId, size);
+    auto position = std::upper_bound(pendingFiles.begin(), pendingFiles.end(), file, [](const File* a, const File* b) {
+        return a->getSize() < b->getSize();
+    });
+    pendingFiles.insert(position, file);
+    return file;
+}
+
 File* Customer::getNextFile()
 {
     if (pendingFiles.empty()) {
@@ -49,6 +62,17 @@ File* Customer::getNextFile()
     return nextFile;
 }
 
+bool Customer::takeFile(File* file)
+{
+    auto it = std::find(pendingFiles.begin(), pendingFiles.end(), file);
+    if (it == pendingFiles.end()) {
+        return false;
+    }
+
+    pendingFiles.erase(it);
+    return true;
+}
+
 void Customer::fileProcessed(File* file)
 {
     if (file) {
@@ -102,6 +126,16 @@ const File& Customer::getPendingFile(int index) const
     return *(pendingFiles[index]);
 }
 
+File& Customer::getPendingFile(int index)
+{
+    return *(pendingFiles[index]);
+}
+
+const File& Customer::getProcessedFile(int index) const
+{
+    return *(processedFiles[index]);
+}
+
 void Customer::updateWaitTimes(double deltaTime)
 {
     for (auto& file : pendingFiles) {
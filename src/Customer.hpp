@@ -9,9 +9,11 @@ public:
     Customer(int id);
     ~Customer();
 
-    void addFile(int size);
+    void addFile(int size, std::uint64_t contentKey = 0);
     void addFile(File* file);
+    File* submitFile(int size);
     File* getNextFile();
+    bool takeFile(File* file);
     void fileProcessed(File* file);
 
     int getId() const;
@@ -22,6 +24,8 @@ public:
     double getAveragePriority() const;
 
     const File& getPendingFile(int index) const;
+    File& getPendingFile(int index);
+    const File& getProcessedFile(int index) const;
 
     void updateWaitTimes(double deltaTime);
     void updatePriorities(int customerCount);
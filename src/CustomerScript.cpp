@@ -0,0 +1,233 @@
+#include "CustomerScript.hpp"
+#include "Simulation.hpp"
+
+CustomerScript::CustomerScript(std::coroutine_handle<promise_type> handle)
+    : handle(handle)
+{
+}
+
+CustomerScript::CustomerScript(CustomerScript&& other) noexcept
+    : handle(other.handle)
+{
+    other.handle = nullptr;
+}
+
+CustomerScript& CustomerScript::operator=(CustomerScript&& other) noexcept
+{
+    if (this != &other) {
+        if (handle) {
+            handle.destroy();
+        }
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+CustomerScript::~CustomerScript()
+{
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+std::coroutine_handle<> CustomerScript::getHandle() const
+{
+    return handle;
+}
+
+bool CustomerScript::isDone() const
+{
+    return !handle || handle.done();
+}
+
+ScriptContext::ScriptContext(Simulation& simulation, ScriptScheduler& scheduler, Customer& customer, unsigned int seed)
+    : simulation(simulation), scheduler(scheduler), customer(customer), random(seed)
+{
+}
+
+bool ScriptContext::SleepAwaitable::await_ready() const
+{
+    return wakeTime <= scheduler.getCurrentTime();
+}
+
+void ScriptContext::SleepAwaitable::await_suspend(std::coroutine_handle<> handle)
+{
+    scheduler.sleepUntil(wakeTime, handle);
+}
+
+bool ScriptContext::FileAwaitable::await_ready() const
+{
+    return !file || file->isProcessed();
+}
+
+void ScriptContext::FileAwaitable::await_suspend(std::coroutine_handle<> handle)
+{
+    scheduler.waitForFile(file, handle);
+}
+
+double ScriptContext::now() const
+{
+    return scheduler.getCurrentTime();
+}
+
+Customer& ScriptContext::getCustomer()
+{
+    return customer;
+}
+
+std::mt19937& ScriptContext::getRandom()
+{
+    return random;
+}
+
+ScriptContext::SleepAwaitable ScriptContext::sleepUntil(double time)
+{
+    return SleepAwaitable{scheduler, time};
+}
+
+ScriptContext::SleepAwaitable ScriptContext::sleepFor(double duration)
+{
+    return SleepAwaitable{scheduler, scheduler.getCurrentTime() + duration};
+}
+
+ScriptContext::FileAwaitable ScriptContext::waitForFile(const File* file)
+{
+    return FileAwaitable{scheduler, file};
+}
+
+ScriptContext::SubmitAwaitable ScriptContext::submitBatch(const std::vector<int>& sizes)
+{
+    auto awaitable = SubmitAwaitable{};
+    for (int size : sizes) {
+        awaitable.files.push_back(simulation.submitFile(customer, size));
+    }
+    return awaitable;
+}
+
+ScriptScheduler::ScriptScheduler()
+    : timerSequence(0), currentTime(0.0), liveScripts(0)
+{
+}
+
+void ScriptScheduler::spawn(std::unique_ptr<ScriptContext> context, const CustomerBehavior& behavior)
+{
+    auto script = behavior(*context);
+    ready.push_back(script.getHandle());
+    scripts.push_back(std::move(script));
+    contexts.push_back(std::move(context));
+    liveScripts++;
+}
+
+void ScriptScheduler::clear()
+{
+    timers = {};
+    fileWaiters.clear();
+    ready.clear();
+    scripts.clear();
+    contexts.clear();
+    timerSequence = 0;
+    currentTime = 0.0;
+    liveScripts = 0;
+}
+
+void ScriptScheduler::run(double now)
+{
+    currentTime = now;
+
+    while (true)
+    {
+        while (!timers.empty() && timers.top().wakeTime <= now)
+        {
+            ready.push_back(timers.top().handle);
+            timers.pop();
+        }
+
+        if (ready.empty())
+        {
+            return;
+        }
+
+        auto runnable = std::move(ready);
+        ready.clear();
+        for (auto handle : runnable)
+        {
+            handle.resume();
+            if (handle.done())
+            {
+                liveScripts--;
+            }
+        }
+    }
+}
+
+void ScriptScheduler::fileCompleted(const File* file)
+{
+    auto range = fileWaiters.equal_range(file);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        ready.push_back(it->second);
+    }
+    fileWaiters.erase(range.first, range.second);
+}
+
+void ScriptScheduler::sleepUntil(double wakeTime, std::coroutine_handle<> handle)
+{
+    timers.push(Timer{wakeTime, timerSequence++, handle});
+}
+
+void ScriptScheduler::waitForFile(const File* file, std::coroutine_handle<> handle)
+{
+    fileWaiters.emplace(file, handle);
+}
+
+double ScriptScheduler::getCurrentTime() const
+{
+    return currentTime;
+}
+
+bool ScriptScheduler::hasLiveScripts() const
+{
+    return liveScripts > 0;
+}
+
+int ScriptScheduler::getLiveScriptCount() const
+{
+    return liveScripts;
+}
+
+CustomerScript runSessions(ScriptContext& context)
+{
+    auto& random = context.getRandom();
+    auto sessionCountDist = std::uniform_int_distribution<>{2, 5};
+    auto batchSizeDist = std::uniform_int_distribution<>{1, 4};
+    auto fileSizeDist = std::uniform_int_distribution<>{1, 100};
+    auto thinkTimeDist = std::exponential_distribution<>{1.0 / 20.0};
+    auto retryDist = std::bernoulli_distribution{0.2};
+
+    int sessionCount = sessionCountDist(random);
+    for (int session = 0; session < sessionCount; session++)
+    {
+        co_await context.sleepFor(thinkTimeDist(random));
+
+        auto sizes = std::vector<int>{};
+        int batchSize = batchSizeDist(random);
+        for (int i = 0; i < batchSize; i++)
+        {
+            sizes.push_back(fileSizeDist(random));
+        }
+
+        auto files = co_await context.submitBatch(sizes);
+        for (auto file : files)
+        {
+            co_await context.waitForFile(file);
+        }
+
+        if (retryDist(random))
+        {
+            auto retrySizes = std::vector<int>(1, files.front()->getSize());
+            auto retried = co_await context.submitBatch(retrySizes);
+            co_await context.waitForFile(retried.front());
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Customer.hpp"
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+class Simulation;
+class ScriptScheduler;
+
+// Coroutine return type for customer behaviour. A script starts suspended
+// and is resumed by the ScriptScheduler on the simulation thread whenever
+// whatever it is waiting for has happened, so a suspended customer costs one
+// coroutine frame and no thread.
+class CustomerScript
+{
+public:
+    struct promise_type
+    {
+        CustomerScript get_return_object()
+        {
+            return CustomerScript{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    CustomerScript(CustomerScript&& other) noexcept;
+    CustomerScript& operator=(CustomerScript&& other) noexcept;
+    ~CustomerScript();
+
+    CustomerScript(const CustomerScript&) = delete;
+    CustomerScript& operator=(const CustomerScript&) = delete;
+
+    std::coroutine_handle<> getHandle() const;
+    bool isDone() const;
+
+private:
+    explicit CustomerScript(std::coroutine_handle<promise_type> handle);
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Handed to each script; everything a script can observe or do goes
+// through here.
+class ScriptContext
+{
+public:
+    ScriptContext(Simulation& simulation, ScriptScheduler& scheduler, Customer& customer, unsigned int seed);
+
+    struct SleepAwaitable
+    {
+        ScriptScheduler& scheduler;
+        double wakeTime;
+
+        bool await_ready() const;
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const {}
+    };
+
+    struct FileAwaitable
+    {
+        ScriptScheduler& scheduler;
+        const File* file;
+
+        bool await_ready() const;
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const {}
+    };
+
+    struct SubmitAwaitable
+    {
+        std::vector<File*> files;
+
+        bool await_ready() const { return true; }
+        void await_suspend(std::coroutine_handle<>) {}
+        std::vector<File*> await_resume() { return std::move(files); }
+    };
+
+    double now() const;
+    Customer& getCustomer();
+    std::mt19937& getRandom();
+
+    SleepAwaitable sleepUntil(double time);
+    SleepAwaitable sleepFor(double duration);
+    FileAwaitable waitForFile(const File* file);
+    SubmitAwaitable submitBatch(const std::vector<int>& sizes);
+
+private:
+    Simulation& simulation;
+    ScriptScheduler& scheduler;
+    Customer& customer;
+    std::mt19937 random;
+};
+
+using CustomerBehavior = std::function<CustomerScript(ScriptContext&)>;
+
+class ScriptScheduler
+{
+public:
+    ScriptScheduler();
+
+    void spawn(std::unique_ptr<ScriptContext> context, const CustomerBehavior& behavior);
+    void clear();
+
+    // Resumes every script whose wake time is <= now or whose awaited file
+    // has completed, until none is runnable.
+    void run(double now);
+    void fileCompleted(const File* file);
+
+    void sleepUntil(double wakeTime, std::coroutine_handle<> handle);
+    void waitForFile(const File* file, std::coroutine_handle<> handle);
+
+    double getCurrentTime() const;
+    bool hasLiveScripts() const;
+    int getLiveScriptCount() const;
+
+private:
+    struct Timer
+    {
+        double wakeTime;
+        unsigned long sequence;
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer& other) const
+        {
+            return wakeTime != other.wakeTime ? wakeTime > other.wakeTime : sequence > other.sequence;
+        }
+    };
+
+    std::vector<std::unique_ptr<ScriptContext>> contexts;
+    std::vector<CustomerScript> scripts;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::unordered_multimap<const File*, std::coroutine_handle<>> fileWaiters;
+    std::vector<std::coroutine_handle<>> ready;
+    unsigned long timerSequence;
+    double currentTime;
+    int liveScripts;
+};
+
+// Closed-loop session workload: think, submit a small batch, wait for all of
+// it, occasionally resubmit a file as a retry, repeat.
+CustomerScript runSessions(ScriptContext& context);
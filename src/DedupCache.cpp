@@ -0,0 +1,86 @@
+#include "DedupCache.hpp"
+
+DedupCache::DedupCache(double capacity, double lookupTime)
+    : capacity(capacity), lookupTime(lookupTime), used(0.0), hits(0), misses(0), sizeSaved(0.0)
+{
+}
+
+bool DedupCache::lookup(std::uint64_t key)
+{
+    auto found = entries.find(key);
+    if (found == entries.end()) {
+        return false;
+    }
+
+    recency.splice(recency.begin(), recency, found->second);
+    return true;
+}
+
+void DedupCache::insert(std::uint64_t key, int size)
+{
+    if (size > capacity) {
+        return;
+    }
+
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        recency.splice(recency.begin(), recency, found->second);
+        return;
+    }
+
+    while (used + size > capacity && !recency.empty()) {
+        used -= recency.back().size;
+        entries.erase(recency.back().key);
+        recency.pop_back();
+    }
+
+    recency.push_front(Entry{key, size});
+    entries[key] = recency.begin();
+    used += size;
+}
+
+void DedupCache::record(bool hit, int size)
+{
+    if (hit) {
+        hits++;
+        sizeSaved += size;
+    } else {
+        misses++;
+    }
+}
+
+double DedupCache::getLookupTime() const
+{
+    return lookupTime;
+}
+
+double DedupCache::getCapacity() const
+{
+    return capacity;
+}
+
+double DedupCache::getUsed() const
+{
+    return used;
+}
+
+long long DedupCache::getHits() const
+{
+    return hits;
+}
+
+long long DedupCache::getMisses() const
+{
+    return misses;
+}
+
+double DedupCache::getHitRate() const
+{
+    auto lookups = hits + misses;
+    return lookups > 0 ? static_cast<double>(hits) / lookups : 0.0;
+}
+
+double DedupCache::getSizeSaved() const
+{
+    return sizeSaved;
+}
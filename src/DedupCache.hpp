@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+// Content already present at the destination, keyed by content key and
+// bounded by total size in KB. Least recently used entries are evicted
+// first. A dispatch whose content is cached skips the transfer and pays
+// only the lookup time.
+class DedupCache
+{
+public:
+    DedupCache(double capacity, double lookupTime);
+
+    // A hit refreshes the entry. Nothing is counted here, since a transfer
+    // interrupted by a directory removal looks its file up again.
+    bool lookup(std::uint64_t key);
+    void insert(std::uint64_t key, int size);
+    // Counts a finished file once, as a hit or a miss
+    void record(bool hit, int size);
+
+    double getLookupTime() const;
+    double getCapacity() const;
+    double getUsed() const;
+    long long getHits() const;
+    long long getMisses() const;
+    double getHitRate() const;
+    double getSizeSaved() const;
+
+private:
+    struct Entry
+    {
+        std::uint64_t key;
+        int size;
+    };
+
+    double capacity;
+    double lookupTime;
+    double used;
+    long long hits;
+    long long misses;
+    double sizeSaved;
+    // Most recently used at the front
+    std::list<Entry> recency;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> entries;
+};
+
+struct DedupConfig
+{
+    bool enabled = false;
+    double capacity = 1024.0;
+    double lookupTime = 0.05;
+};
@@ -2,7 +2,9 @@
 
 Directory::Directory(int id)
     : id(id), processing(false), customer(nullptr), file(nullptr),
-        processingTime(0.0), elapsedTime(0.0), progress(0)
+        processingTime(0.0), elapsedTime(0.0), progress(0),
+        bandwidthPool(nullptr), transferHandle(0), transferWork(0.0), heldFile(nullptr),
+        dedupCache(nullptr), dedupHit(false)
 {
 }
 
@@ -13,7 +15,7 @@ bool Directory::isProcessing() const
 
 bool Directory::assignFile(Customer* customer, File* file)
 {
-    if (processing) {
+    if (processing || heldFile) {
         return false;
     }
     
@@ -21,7 +23,17 @@ bool Directory::assignFile(Customer* customer, File* file)
     this->file = file;
     
     if (file) {
-        processingTime = calculateProcessingTime(file->getSize());
+        dedupHit = dedupCache && file->getContentKey() != 0 &&
+            dedupCache->lookup(file->getContentKey());
+        if (dedupHit) {
+            processingTime = dedupCache->getLookupTime();
+        } else if (bandwidthPool) {
+            transferWork = calculateTransferWork(file->getSize());
+            transferHandle = bandwidthPool->start(transferWork);
+            processingTime = transferWork / bandwidthPool->getRate();
+        } else {
+            processingTime = calculateProcessingTime(file->getSize());
+        }
         elapsedTime = 0.0;
         progress = 0;
         processing = true;
@@ -31,18 +43,37 @@ bool Directory::assignFile(Customer* customer, File* file)
     return false;
 }
 
-void Directory::update(double deltaTime)
+File* Directory::update(double deltaTime)
 {
     if (!processing || !file) {
-        return;
+        return nullptr;
     }
     
     elapsedTime += deltaTime;
     
-    progress = static_cast<int>((elapsedTime / processingTime) * 100);
+    bool finished = false;
+    if (bandwidthPool && transferHandle != 0) {
+        double remaining = bandwidthPool->getRemainingWork(transferHandle);
+        progress = static_cast<int>((1.0 - remaining / transferWork) * 100);
+        finished = bandwidthPool->isFinished(transferHandle);
+        if (finished) {
+            bandwidthPool->release(transferHandle);
+            transferHandle = 0;
+        }
+    } else {
+        progress = static_cast<int>((elapsedTime / processingTime) * 100);
+        finished = elapsedTime >= processingTime;
+    }
     if (progress > 100) progress = 100;
     
-    if (elapsedTime >= processingTime) {
+    if (finished) {
+        auto completed = file;
+        if (dedupCache && file->getContentKey() != 0) {
+            dedupCache->record(dedupHit, file->getSize());
+            if (!dedupHit) {
+                dedupCache->insert(file->getContentKey(), file->getSize());
+            }
+        }
         if (customer && file) {
             customer->fileProcessed(file);
         }
@@ -52,7 +83,10 @@ void Directory::update(double deltaTime)
         file = nullptr;
         elapsedTime = 0.0;
         progress = 0;
+        return completed;
     }
+
+    return nullptr;
 }
 
 int Directory::getId() const
@@ -85,18 +119,103 @@ double Directory::getRemainingTime() const
     if (!processing) {
         return 0.0;
     }
+
+    if (bandwidthPool && transferHandle != 0) {
+        return bandwidthPool->getRemainingWork(transferHandle) / bandwidthPool->getRate();
+    }
     
     return processingTime - elapsedTime;
 }
 
 void Directory::reset()
 {
+    cancelTransfer();
     processing = false;
     customer = nullptr;
     file = nullptr;
     processingTime = 0.0;
     elapsedTime = 0.0;
     progress = 0;
+    heldFile = nullptr;
+    localQueue.clear();
+}
+
+void Directory::holdFile(File* file)
+{
+    heldFile = file;
+}
+
+File* Directory::getHeldFile() const
+{
+    return heldFile;
+}
+
+void Directory::releaseHeldFile()
+{
+    heldFile = nullptr;
+}
+
+bool Directory::isBlocked() const
+{
+    return heldFile != nullptr;
+}
+
+void Directory::setBandwidthPool(BandwidthPool* pool)
+{
+    cancelTransfer();
+    bandwidthPool = pool;
+}
+
+BandwidthPool* Directory::getBandwidthPool() const
+{
+    return bandwidthPool;
+}
+
+void Directory::setDedupCache(DedupCache* cache)
+{
+    dedupCache = cache;
+}
+
+void Directory::enqueueLocal(Customer* customer, File* file)
+{
+    localQueue.push_back(QueuedFile{customer, file});
+}
+
+void Directory::requeueLocal(Customer* customer, File* file)
+{
+    localQueue.push_front(QueuedFile{customer, file});
+}
+
+bool Directory::popLocal(QueuedFile& queued)
+{
+    if (localQueue.empty()) {
+        return false;
+    }
+
+    queued = localQueue.front();
+    localQueue.pop_front();
+    return true;
+}
+
+bool Directory::stealLocal(QueuedFile& queued)
+{
+    if (localQueue.empty()) {
+        return false;
+    }
+
+    queued = localQueue.back();
+    localQueue.pop_back();
+    return true;
+}
+
+int Directory::getLocalQueueSize() const
+{
+    return static_cast<int>(localQueue.size());
+}
+
+void Directory::clearLocalQueue()
+{
+    localQueue.clear();
 }
 
 double Directory::calculateProcessingTime(int fileSize) const
@@ -105,4 +224,19 @@ double Directory::calculateProcessingTime(int fileSize) const
     // Minimum processing time is 0.5 seconds
     double time = fileSize * 0.1;
     return (time < 0.5) ? 0.5 : time;
+}
+
+double Directory::calculateTransferWork(int fileSize) const
+{
+    // Work in KB; the 5 KB floor mirrors the 0.5 second minimum of the
+    // private model at its 10 KB/s rate
+    return (fileSize < 5) ? 5.0 : fileSize;
+}
+
+void Directory::cancelTransfer()
+{
+    if (bandwidthPool && transferHandle != 0) {
+        bandwidthPool->cancel(transferHandle);
+    }
+    transferHandle = 0;
 }
\ No newline at end of file
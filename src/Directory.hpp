@@ -1,7 +1,16 @@
 #pragma once
 
+#include "BandwidthPool.hpp"
 #include "Customer.hpp"
+#include "DedupCache.hpp"
 #include "File.hpp"
+#include <deque>
+
+struct QueuedFile
+{
+    Customer* customer;
+    File* file;
+};
 
 class Directory
 {
@@ -10,7 +19,7 @@ public:
     
     bool isProcessing() const;
     bool assignFile(Customer* customer, File* file);
-    void update(double deltaTime);
+    File* update(double deltaTime);
     
     int getId() const;
     int getProgress() const;
@@ -20,6 +29,31 @@ public:
     double getRemainingTime() const;
     
     void reset();
+
+    // A finished file the next pipeline stage had no room for. The directory
+    // stays blocked, taking no new work, until the file is released.
+    void holdFile(File* file);
+    File* getHeldFile() const;
+    void releaseHeldFile();
+    bool isBlocked() const;
+
+    // With a pool set, transfers draw from its shared bandwidth instead of
+    // the private per-directory processing time model
+    void setBandwidthPool(BandwidthPool* pool);
+    BandwidthPool* getBandwidthPool() const;
+
+    // With a cache set, content already at the destination is not transferred
+    void setDedupCache(DedupCache* cache);
+
+    // Local work queue used by the work-stealing scheduler. The owner pops
+    // from the front, thieves take from the back.
+    void enqueueLocal(Customer* customer, File* file);
+    // Puts a file back where the owner pops next
+    void requeueLocal(Customer* customer, File* file);
+    bool popLocal(QueuedFile& queued);
+    bool stealLocal(QueuedFile& queued);
+    int getLocalQueueSize() const;
+    void clearLocalQueue();
     
 private:
     int id;                
@@ -29,6 +63,15 @@ private:
     double processingTime; 
     double elapsedTime;    
     int progress;
+    std::deque<QueuedFile> localQueue;
+    BandwidthPool* bandwidthPool;
+    int transferHandle;
+    double transferWork;
+    File* heldFile;
+    DedupCache* dedupCache;
+    bool dedupHit;
     
     double calculateProcessingTime(int fileSize) const;
+    double calculateTransferWork(int fileSize) const;
+    void cancelTransfer();
 };
\ No newline at end of file
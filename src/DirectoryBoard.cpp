@@ -0,0 +1,196 @@
+#include "DirectoryBoard.hpp"
+
+#include <QHelpEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QRegion>
+#include <QToolTip>
+#include <algorithm>
+#include <cmath>
+
+DirectoryBoard::DirectoryBoard(QWidget* parent)
+    : QWidget(parent), cellSize(MaxCellSize), columns(1)
+{
+    setMouseTracking(true);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumHeight(MaxCellSize + CellGap);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+    // Progress ramps from the idle tone towards the highlight colour
+    idleColor = palette().color(QPalette::Mid);
+    auto hot = palette().color(QPalette::Highlight);
+    for (int i = 0; i < static_cast<int>(heat.size()); i++) {
+        double t = 0.25 + 0.75 * i / 100.0;
+        heat[i] = QColor::fromRgbF(
+            idleColor.redF() + (hot.redF() - idleColor.redF()) * t,
+            idleColor.greenF() + (hot.greenF() - idleColor.greenF()) * t,
+            idleColor.blueF() + (hot.blueF() - idleColor.blueF()) * t);
+    }
+}
+
+void DirectoryBoard::setDirectories(const std::vector<DirectorySnapshot>& next)
+{
+    bool relayout = next.size() != directories.size();
+    if (relayout) {
+        directories = next;
+        layoutCells();
+        update();
+        return;
+    }
+
+    // One dirty span per row keeps the region small however many cells change
+    auto dirty = QRegion{};
+    int rowFirst = -1;
+    int rowLast = -1;
+    auto flushRow = [&]() {
+        if (rowFirst >= 0) {
+            dirty += cellRect(rowFirst).united(cellRect(rowLast));
+        }
+        rowFirst = rowLast = -1;
+    };
+
+    for (int i = 0; i < static_cast<int>(next.size()); i++) {
+        if (i % columns == 0) {
+            flushRow();
+        }
+
+        const auto& before = directories[i];
+        const auto& after = next[i];
+        if (before.id != after.id || &cellColor(before) != &cellColor(after)) {
+            if (rowFirst < 0) rowFirst = i;
+            rowLast = i;
+        }
+    }
+    flushRow();
+
+    directories = next;
+    if (!dirty.isEmpty()) {
+        update(dirty);
+    }
+}
+
+void DirectoryBoard::clearActivity()
+{
+    auto idle = directories;
+    for (auto& directory : idle) {
+        directory.processing = false;
+        directory.progress = 0;
+        directory.customerId = 0;
+        directory.fileId = 0;
+        directory.fileSize = 0;
+    }
+    setDirectories(idle);
+}
+
+bool DirectoryBoard::event(QEvent* event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        auto help = static_cast<QHelpEvent*>(event);
+        int index = cellAt(help->pos());
+        if (index < 0) {
+            QToolTip::hideText();
+            event->ignore();
+            return true;
+        }
+
+        const auto& directory = directories[index];
+        auto text = directory.processing
+            ? QString("Directory %1\nCustomer %2, File %3, %4KB\n%5% done")
+                .arg(directory.id)
+                .arg(directory.customerId)
+                .arg(directory.fileId)
+                .arg(directory.fileSize)
+                .arg(directory.progress)
+            : QString("Directory %1\nIdle").arg(directory.id);
+        QToolTip::showText(help->globalPos(), text, this, cellRect(index));
+        return true;
+    }
+    return QWidget::event(event);
+}
+
+void DirectoryBoard::paintEvent(QPaintEvent* event)
+{
+    auto painter = QPainter{this};
+    auto exposed = event->rect();
+    painter.fillRect(exposed, palette().window());
+
+    if (directories.empty()) {
+        return;
+    }
+
+    // Visit only the rows and columns that intersect the exposed rect
+    int pitch = cellSize + CellGap;
+    int firstRow = std::max(0, exposed.top() / pitch);
+    int lastRow = exposed.bottom() / pitch;
+    int firstColumn = std::max(0, exposed.left() / pitch);
+    int lastColumn = std::min(columns - 1, exposed.right() / pitch);
+    bool labelled = cellSize >= MaxCellSize;
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            int index = row * columns + column;
+            if (index >= static_cast<int>(directories.size())) {
+                break;
+            }
+
+            const auto& directory = directories[index];
+            auto rect = cellRect(index);
+            painter.fillRect(rect, cellColor(directory));
+            if (labelled) {
+                painter.setPen(palette().color(directory.processing ? QPalette::HighlightedText : QPalette::Text));
+                painter.drawText(rect, Qt::AlignCenter, QString::number(directory.id));
+            }
+        }
+    }
+}
+
+void DirectoryBoard::resizeEvent(QResizeEvent*)
+{
+    layoutCells();
+    update();
+}
+
+void DirectoryBoard::layoutCells()
+{
+    // Largest square cell that fits every directory in the current area
+    int count = std::max(1, static_cast<int>(directories.size()));
+    int available = std::max(1, width() * height());
+    int size = static_cast<int>(std::sqrt(static_cast<double>(available) / count)) - CellGap;
+    cellSize = std::clamp(size, MinCellSize, MaxCellSize);
+    while (cellSize > MinCellSize) {
+        int perRow = std::max(1, width() / (cellSize + CellGap));
+        int rows = (count + perRow - 1) / perRow;
+        if (rows * (cellSize + CellGap) <= height()) {
+            break;
+        }
+        cellSize--;
+    }
+    columns = std::max(1, width() / (cellSize + CellGap));
+}
+
+QRect DirectoryBoard::cellRect(int index) const
+{
+    int pitch = cellSize + CellGap;
+    return QRect{(index % columns) * pitch, (index / columns) * pitch, cellSize, cellSize};
+}
+
+int DirectoryBoard::cellAt(const QPoint& position) const
+{
+    int pitch = cellSize + CellGap;
+    if (position.x() < 0 || position.y() < 0) {
+        return -1;
+    }
+
+    int column = position.x() / pitch;
+    int index = (position.y() / pitch) * columns + column;
+    if (column >= columns || index >= static_cast<int>(directories.size()) ||
+        !cellRect(index).contains(position)) {
+        return -1;
+    }
+    return index;
+}
+
+const QColor& DirectoryBoard::cellColor(const DirectorySnapshot& directory) const
+{
+    return directory.processing ? heat[std::clamp(directory.progress, 0, 100)] : idleColor;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "SimulationSnapshot.hpp"
+#include <QColor>
+#include <QWidget>
+#include <array>
+#include <vector>
+
+// Paints every directory as one cell of a heatmap, coloured by transfer
+// progress. Only cells whose appearance changed since the last snapshot are
+// invalidated, and painting visits only the cells inside the exposed rect,
+// so the cost scales with what changed rather than with the directory count.
+class DirectoryBoard : public QWidget
+{
+    Q_OBJECT
+
+public:
+    DirectoryBoard(QWidget* parent = nullptr);
+
+    void setDirectories(const std::vector<DirectorySnapshot>& directories);
+    void clearActivity();
+
+protected:
+    bool event(QEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+private:
+    static constexpr int MinCellSize = 4;
+    static constexpr int MaxCellSize = 48;
+    static constexpr int CellGap = 1;
+
+    void layoutCells();
+    QRect cellRect(int index) const;
+    int cellAt(const QPoint& position) const;
+    const QColor& cellColor(const DirectorySnapshot& directory) const;
+
+    std::vector<DirectorySnapshot> directories;
+    std::array<QColor, 101> heat;
+    QColor idleColor;
+    int cellSize;
+    int columns;
+};
@@ -1,7 +1,8 @@
 #include "File.hpp"
 
 File::File(int id, int size)
-    : id(id), size(size), waitTime(0.0), priority(0.0), processed(false)
+    : id(id), size(size), waitTime(0.0), priority(0.0), processed(false),
+      startTime(0.0), dispatchPriority(0.0), enqueueTime(0.0), exitTime(0.0), contentKey(0)
 {
 }
 
@@ -30,6 +31,31 @@ bool File::isProcessed() const
     return processed;
 }
 
+double File::getStartTime() const
+{
+    return startTime;
+}
+
+double File::getDispatchPriority() const
+{
+    return dispatchPriority;
+}
+
+double File::getEnqueueTime() const
+{
+    return enqueueTime;
+}
+
+double File::getExitTime() const
+{
+    return exitTime;
+}
+
+std::uint64_t File::getContentKey() const
+{
+    return contentKey;
+}
+
 void File::setId(int id)
 {
     this->id = id;
@@ -58,4 +84,25 @@ void File::updatePriority(int customerCount)
     if (size <= 0) size = 1;
     
     priority = (waitTime / customerCount) + (static_cast<double>(customerCount) / size);
-}
\ No newline at end of file
+}
+
+void File::markDispatched(double time)
+{
+    startTime = time;
+    dispatchPriority = priority;
+}
+
+void File::markEnqueued(double time)
+{
+    enqueueTime = time;
+}
+
+void File::markExited(double time)
+{
+    exitTime = time;
+}
+
+void File::setContentKey(std::uint64_t key)
+{
+    contentKey = key;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 class File
 {
 public:
@@ -10,11 +12,23 @@ public:
     double getPriority() const;
     double getWaitTime() const;
     bool isProcessed() const;
+    double getStartTime() const;
+    double getDispatchPriority() const;
+    // First time the file joined a queue; re-queueing keeps it
+    double getEnqueueTime() const;
+    // When the file left the system: its directory or the last pipeline stage
+    double getExitTime() const;
+    // Files with equal non-zero keys have identical content
+    std::uint64_t getContentKey() const;
 
     void setId(int id);
     void setProcessed(bool processed);
     void updateWaitTime(double deltaTime);
     void updatePriority(int customerCount);
+    void markDispatched(double time);
+    void markEnqueued(double time);
+    void markExited(double time);
+    void setContentKey(std::uint64_t key);
 
 private:
     int id;
@@ -22,4 +36,9 @@ private:
     double waitTime;
     double priority;
     bool processed;
+    double startTime;
+    double dispatchPriority;
+    double enqueueTime;
+    double exitTime;
+    std::uint64_t contentKey;
 };
\ No newline at end of file
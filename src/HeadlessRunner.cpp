@@ -0,0 +1,893 @@
+#include "HeadlessRunner.hpp"
+#include "CapacityTuner.hpp"
+#include "RegressionHarness.hpp"
+#include "ResultWriter.hpp"
+#include "ShardedSimulation.hpp"
+#include "SnapshotServer.hpp"
+#include "TransferCalibration.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+HeadlessRunner::HeadlessRunner(int argc, char* argv[])
+    : customerCount(100), directoryCount(5), threadCount(1), shardCount(1), seed(1), sessions(false), profile(false),
+      tune(false), regress(false), verify(false), calibrationMegabytes(64), updateBaseline(false), regressionThreshold(0.25), serveSpeed(1.0), sloSeconds(60.0), sloPercentile(0.99), maxDirectories(64), replications(5),
+      sweepMaxDirectories(0), mode("compare")
+{
+    for (int i = 1; i < argc; i++)
+    {
+        auto hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--customers") == 0 && hasValue)
+        {
+            customerCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--directories") == 0 && hasValue)
+        {
+            directoryCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+        {
+            threadCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--shards") == 0 && hasValue)
+        {
+            shardCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue)
+        {
+            seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--sessions") == 0)
+        {
+            sessions = true;
+        } else if (std::strcmp(argv[i], "--profile") == 0)
+        {
+            profile = true;
+        } else if (std::strcmp(argv[i], "--tune") == 0)
+        {
+            tune = true;
+        } else if (std::strcmp(argv[i], "--regress") == 0)
+        {
+            regress = true;
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue)
+        {
+            baselinePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--update-baseline") == 0)
+        {
+            updateBaseline = true;
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && hasValue)
+        {
+            regressionThreshold = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--slo") == 0 && hasValue)
+        {
+            sloSeconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--percentile") == 0 && hasValue)
+        {
+            sloPercentile = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--max-directories") == 0 && hasValue)
+        {
+            maxDirectories = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--replications") == 0 && hasValue)
+        {
+            replications = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--min-files") == 0 && hasValue)
+        {
+            workload.minFilesPerCustomer = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--max-files") == 0 && hasValue)
+        {
+            workload.maxFilesPerCustomer = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--min-size") == 0 && hasValue)
+        {
+            workload.minFileSize = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--max-size") == 0 && hasValue)
+        {
+            workload.maxFileSize = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--bandwidth") == 0 && hasValue)
+        {
+            bandwidth.enabled = true;
+            bandwidth.poolBandwidth = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--directory-cap") == 0 && hasValue)
+        {
+            bandwidth.perDirectoryCap = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--pools") == 0 && hasValue)
+        {
+            bandwidth.poolCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--stage") == 0 && hasValue)
+        {
+            auto stage = StageSpec{};
+            auto error = std::string{};
+            if (parseStageSpec(argv[++i], stage, error))
+            {
+                pipeline.stages.push_back(stage);
+            } else {
+                std::cerr << "Ignoring --stage: " << error << "\n";
+            }
+        } else if (std::strcmp(argv[i], "--verify") == 0)
+        {
+            verify = true;
+        } else if (std::strcmp(argv[i], "--scratch-dir") == 0 && hasValue)
+        {
+            scratchDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--calibrate-mb") == 0 && hasValue)
+        {
+            calibrationMegabytes = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--steady-state") == 0)
+        {
+            steadyState.enabled = true;
+            steadyState.stopWhenPrecise = false;
+        } else if (std::strcmp(argv[i], "--precision") == 0 && hasValue)
+        {
+            steadyState.enabled = true;
+            steadyState.stopWhenPrecise = true;
+            steadyState.relativePrecision = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--batch-size") == 0 && hasValue)
+        {
+            steadyState.batchSize = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeat-probability") == 0 && hasValue)
+        {
+            workload.repeatProbability = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--dedup-cache") == 0 && hasValue)
+        {
+            dedup.enabled = true;
+            dedup.capacity = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--lookup-time") == 0 && hasValue)
+        {
+            dedup.lookupTime = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--sweep-dedup") == 0 && hasValue)
+        {
+            auto sizes = std::istringstream{argv[++i]};
+            auto size = std::string{};
+            while (std::getline(sizes, size, ','))
+            {
+                dedupSweepSizes.push_back(std::atof(size.c_str()));
+            }
+        } else if (std::strcmp(argv[i], "--sweep-directories") == 0 && hasValue)
+        {
+            sweepMaxDirectories = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--timeseries-out") == 0 && hasValue)
+        {
+            timeSeriesPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--results-out") == 0 && hasValue)
+        {
+            resultsPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--serve") == 0 && hasValue)
+        {
+            servePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--speed") == 0 && hasValue)
+        {
+            serveSpeed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--trace") == 0 && hasValue)
+        {
+            tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--convert-trace") == 0 && i + 2 < argc)
+        {
+            convertInputPath = argv[++i];
+            convertOutputPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--mode") == 0 && hasValue)
+        {
+            mode = argv[++i];
+        }
+    }
+
+    if (customerCount < 1) customerCount = 1;
+    if (directoryCount < 1) directoryCount = 1;
+    if (threadCount < 1) threadCount = 1;
+    if (shardCount < 1) shardCount = 1;
+    if (workload.minFilesPerCustomer < 1) workload.minFilesPerCustomer = 1;
+    if (workload.maxFilesPerCustomer < workload.minFilesPerCustomer) workload.maxFilesPerCustomer = workload.minFilesPerCustomer;
+    if (workload.minFileSize < 1) workload.minFileSize = 1;
+    if (workload.maxFileSize < workload.minFileSize) workload.maxFileSize = workload.minFileSize;
+    if (bandwidth.poolCount < 1) bandwidth.poolCount = 1;
+    if (bandwidth.poolBandwidth <= 0.0) bandwidth.poolBandwidth = 1.0;
+    if (bandwidth.perDirectoryCap <= 0.0) bandwidth.perDirectoryCap = 1.0;
+    if (regressionThreshold < 0.0) regressionThreshold = 0.0;
+    if (calibrationMegabytes < 1) calibrationMegabytes = 1;
+    if (workload.repeatProbability < 0.0) workload.repeatProbability = 0.0;
+    if (workload.repeatProbability > 1.0) workload.repeatProbability = 1.0;
+    if (dedup.capacity < 0.0) dedup.capacity = 0.0;
+    if (dedup.lookupTime < 0.0) dedup.lookupTime = 0.0;
+    if (steadyState.relativePrecision <= 0.0) steadyState.relativePrecision = 0.05;
+    if (steadyState.batchSize < 1) steadyState.batchSize = 1;
+    if (serveSpeed < 0.0) serveSpeed = 1.0;
+    if (scratchDirectory.empty())
+    {
+        auto tmpdir = std::getenv("TMPDIR");
+        scratchDirectory = tmpdir && *tmpdir ? tmpdir : "/tmp";
+    }
+}
+
+bool HeadlessRunner::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int HeadlessRunner::run()
+{
+    if (!convertInputPath.empty())
+    {
+        return convertTrace();
+    }
+
+    if (verify && !addVerifyStage())
+    {
+        return 1;
+    }
+
+    // Falling back to the synthetic workload would report on the wrong run
+    if (!tracePath.empty())
+    {
+        auto source = TraceReplaySource{};
+        auto error = std::string{};
+        if (!source.open(tracePath, error))
+        {
+            std::cerr << "Cannot replay trace: " << error << "\n";
+            return 1;
+        }
+    }
+
+    std::cout << "Customers: " << customerCount
+              << ", Directories: " << directoryCount
+              << ", Threads: " << threadCount
+              << ", Seed: " << seed
+              << (sessions ? ", Workload: closed-loop sessions" : "")
+              << (tracePath.empty() ? "" : ", Workload: trace " + tracePath) << "\n";
+    if (bandwidth.enabled)
+    {
+        std::cout << "Shared bandwidth: " << bandwidth.poolCount << " pool(s) of "
+                  << bandwidth.poolBandwidth << " KB/s, " << bandwidth.perDirectoryCap
+                  << " KB/s per directory\n";
+    }
+    for (const auto& stage : pipeline.stages)
+    {
+        std::cout << "Stage " << stage.name << ": " << stage.workerCount << " worker(s), "
+                  << (stage.policy == StagePolicy::SmallestFirst ? "smallest first" : "fifo") << ", "
+                  << stage.setupTime << " secs + size / " << stage.rate << " KB/s"
+                  << (stage.model == ServiceModel::Exponential ? " (exponential)" : "")
+                  << ", buffer " << stage.bufferCapacity << "\n";
+    }
+    std::cout << "\n";
+
+    if (tune)
+    {
+        return runTuner();
+    }
+
+    if (regress)
+    {
+        return runRegression();
+    }
+
+    if (sweepMaxDirectories > 0)
+    {
+        return sweepDirectories();
+    }
+
+    if (!dedupSweepSizes.empty())
+    {
+        return sweepDedupCache();
+    }
+
+    if (!servePath.empty())
+    {
+        if (shardCount > 1)
+        {
+            std::cerr << "Sharded runs cannot be served\n";
+            return 1;
+        }
+        return runServer();
+    }
+
+    if (shardCount > 1)
+    {
+        if (sessions || !tracePath.empty() || !pipeline.stages.empty() || bandwidth.enabled || dedup.enabled)
+        {
+            std::cerr << "Closed-loop sessions, trace replay, pipeline stages, shared bandwidth and dedup "
+                         "are not supported in sharded runs\n";
+            return 1;
+        }
+        return runSharded();
+    }
+
+    if (mode == "central" || mode == "compare")
+    {
+        printReport(runOnce(SchedulingMode::CentralGreedy));
+    }
+    if (mode == "stealing" || mode == "compare")
+    {
+        printReport(runOnce(SchedulingMode::WorkStealing));
+    }
+
+    if (mode != "central" && mode != "stealing" && mode != "compare")
+    {
+        std::cerr << "Unknown mode: " << mode << " (expected central, stealing or compare)\n";
+        return 1;
+    }
+    return 0;
+}
+
+HeadlessRunner::RunReport HeadlessRunner::runOnce(SchedulingMode schedulingMode)
+{
+    return runOnce(schedulingMode, directoryCount);
+}
+
+HeadlessRunner::RunReport HeadlessRunner::runOnce(SchedulingMode schedulingMode, int directories)
+{
+    auto simulation = Simulation{directories};
+    configureSimulation(simulation, schedulingMode);
+    auto runName = std::string{schedulingMode == SchedulingMode::WorkStealing ? "stealing" : "central"};
+    auto results = ResultWriter{};
+    if (!resultsPath.empty() && sweepMaxDirectories == 0 && dedupSweepSizes.empty())
+    {
+        auto error = std::string{};
+        if (results.open(outputPathFor(resultsPath, runName), error))
+        {
+            simulation.setCompletionObserver([&results](const FileResult& result) { results.record(result); });
+        } else {
+            std::cerr << "Result output unavailable: " << error << "\n";
+        }
+    }
+    simulation.initialize(customerCount);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    while (!simulation.allFilesProcessed() && !simulation.reachedSteadyState())
+    {
+        simulation.step();
+    }
+    auto wallEnd = std::chrono::steady_clock::now();
+
+    if (results.isOpen())
+    {
+        auto error = std::string{};
+        if (results.close(error))
+        {
+            std::cout << "Wrote " << results.getRowCount() << " file results to " << outputPathFor(resultsPath, runName);
+            if (results.getDroppedCount() > 0)
+            {
+                std::cout << " (" << results.getDroppedCount() << " dropped)";
+            }
+            std::cout << "\n";
+        } else {
+            std::cerr << "Result output failed: " << error << "\n";
+        }
+    }
+
+    if (simulation.getSkippedTraceRecordCount() > 0)
+    {
+        std::cerr << "Skipped " << simulation.getSkippedTraceRecordCount()
+                  << " trace records whose customer id or size does not fit in an int\n";
+    }
+
+    auto report = reportFor(simulation, schedulingMode, std::chrono::duration<double>(wallEnd - wallStart).count());
+
+    if (!timeSeriesPath.empty() && sweepMaxDirectories == 0 && dedupSweepSizes.empty())
+    {
+        exportTimeSeries(simulation, runName);
+    }
+    return report;
+}
+
+void HeadlessRunner::configureSimulation(Simulation& simulation, SchedulingMode schedulingMode) const
+{
+    simulation.setSeed(seed);
+    simulation.setSchedulingMode(schedulingMode);
+    simulation.setThreadCount(threadCount);
+    simulation.setWorkloadSpec(workload);
+    simulation.setBandwidthConfig(bandwidth);
+    simulation.setPipeline(pipeline);
+    simulation.setDedupConfig(dedup);
+    simulation.setSteadyStateConfig(steadyState);
+    if (sessions)
+    {
+        simulation.setCustomerBehavior(runSessions);
+    }
+    if (!tracePath.empty())
+    {
+        auto error = std::string{};
+        if (!simulation.setTraceReplay(tracePath, error))
+        {
+            std::cerr << "Trace replay unavailable: " << error << "\n";
+        }
+    }
+}
+
+HeadlessRunner::RunReport HeadlessRunner::reportFor(const Simulation& simulation, SchedulingMode schedulingMode, double wallTime) const
+{
+    auto report = RunReport{};
+    report.mode = schedulingMode == SchedulingMode::WorkStealing ? "work-stealing" : "central-greedy";
+    report.elapsedTime = simulation.getElapsedTime();
+    report.wallTime = wallTime;
+    report.processedFiles = simulation.getProcessedFilesCount();
+    report.averageWaitTime = report.processedFiles > 0
+        ? simulation.getTotalWaitTime() / report.processedFiles : 0.0;
+    report.p99WaitTime = simulation.getWaitTimePercentile(0.99);
+    report.steals = simulation.getStealCount();
+    report.locality = simulation.getLocality();
+    report.hasLocality = true;
+    report.phaseStats = simulation.getProfiler().getStats();
+    report.stageStats = simulation.getPipeline().getStats(report.elapsedTime);
+    report.meanLatency = simulation.getPipeline().getMeanLatency();
+    report.p99Latency = simulation.getPipeline().getLatencyPercentile(0.99);
+    auto cache = simulation.getDedupCache();
+    report.dedupEnabled = cache != nullptr;
+    report.dedupHitRate = cache ? cache->getHitRate() : 0.0;
+    report.dedupSaved = cache ? cache->getSizeSaved() : 0.0;
+    const auto& detector = simulation.getSteadyState();
+    report.steadyStateEnabled = steadyState.enabled;
+    report.steadyStateReached = detector.hasConverged();
+    report.steadyStateMean = detector.getMean();
+    report.steadyStateHalfWidth = detector.getHalfWidth();
+    report.warmupFiles = detector.getWarmupObservations();
+    report.warmupTime = detector.getWarmupTime();
+    return report;
+}
+
+int HeadlessRunner::runServer()
+{
+    auto schedulingMode = mode == "stealing" ? SchedulingMode::WorkStealing : SchedulingMode::CentralGreedy;
+    auto simulation = Simulation{directoryCount};
+    configureSimulation(simulation, schedulingMode);
+    simulation.setPublishCustomers(true);
+    simulation.setSpeed(serveSpeed);
+    simulation.initialize(customerCount);
+
+    auto server = SnapshotServer{simulation};
+    auto error = std::string{};
+    if (!server.start(servePath, error))
+    {
+        std::cerr << "Cannot serve snapshots: " << error << "\n";
+        return 1;
+    }
+    std::cout << "Serving snapshots on " << servePath << " at ";
+    if (serveSpeed == Simulation::Unthrottled)
+    {
+        std::cout << "unthrottled speed\n";
+    } else {
+        std::cout << serveSpeed << "x real time\n";
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    simulation.start();
+    while (simulation.isRunning())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    auto wallEnd = std::chrono::steady_clock::now();
+    simulation.stop();
+
+    // Give attached viewers a few frames to receive the final snapshot
+    std::this_thread::sleep_for(std::chrono::milliseconds(10 * SnapshotServer::FrameIntervalMs));
+    server.stop();
+
+    std::cout << "Sent " << server.getFrameCount() << " frames, " << server.getBytesSent() << " bytes to "
+              << server.getConnectionCount() << " viewer connection(s)\n";
+    printReport(reportFor(simulation, schedulingMode, std::chrono::duration<double>(wallEnd - wallStart).count()));
+    return 0;
+}
+
+bool HeadlessRunner::addVerifyStage()
+{
+    auto calibration = TransferCalibration{};
+    auto error = std::string{};
+    if (!calibrateTransfer(scratchDirectory, static_cast<std::size_t>(calibrationMegabytes) << 20, calibration, error))
+    {
+        std::cerr << "Verify calibration failed: " << error << "\n";
+        return false;
+    }
+    if (!calibration.verified)
+    {
+        std::cerr << "Verify calibration failed: the scratch copy does not match its source\n";
+        return false;
+    }
+
+    // The verify stage costs the same fraction of a directory's transfer
+    // time as checksumming did of the real copy
+    double directoryRate = bandwidth.enabled ? bandwidth.perDirectoryCap : 10.0;
+    double verifyRate = directoryRate * calibration.verifyBytesPerSecond / calibration.copyBytesPerSecond;
+
+    auto stage = StageSpec{};
+    stage.name = "verify";
+    stage.workerCount = directoryCount;
+    stage.rate = verifyRate;
+    stage.bufferCapacity = 2 * directoryCount;
+    pipeline.stages.push_back(stage);
+
+    const double megabyte = 1024.0 * 1024.0;
+    std::cout << std::fixed << std::setprecision(1)
+              << "Calibrated on " << calibrationMegabytes << " MB in " << scratchDirectory << ":\n"
+              << "  Copy:           " << calibration.copyBytesPerSecond / megabyte << " MB/s\n"
+              << "  Verify:         " << calibration.verifyBytesPerSecond / megabyte << " MB/s (read back + CRC32C)\n"
+              << "  CRC32C alone:   " << calibration.checksumBytesPerSecond / megabyte << " MB/s ("
+              << (calibration.hardwareChecksum ? "SSE4.2" : "portable table") << ")\n"
+              << std::setprecision(2)
+              << "  Verify stage:   " << verifyRate << " KB/s per worker against "
+              << directoryRate << " KB/s per directory\n"
+              << std::defaultfloat << std::setprecision(6);
+    return true;
+}
+
+int HeadlessRunner::convertTrace()
+{
+    auto error = std::string{};
+    if (!convertCsvTrace(convertInputPath, convertOutputPath, error))
+    {
+        std::cerr << "Trace conversion failed: " << error << "\n";
+        return 1;
+    }
+
+    auto source = TraceReplaySource{};
+    if (!source.open(convertOutputPath, error))
+    {
+        std::cerr << "Converted trace is unreadable: " << error << "\n";
+        return 1;
+    }
+
+    std::cout << "Wrote " << source.getRecordCount() << " records to " << convertOutputPath << "\n";
+    return 0;
+}
+
+int HeadlessRunner::runSharded()
+{
+    auto sharded = ShardedSimulation{shardCount, directoryCount};
+    sharded.setSeed(seed);
+    sharded.setThreadCount(threadCount);
+    sharded.setWorkloadSpec(workload);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    if (!sharded.run(customerCount))
+    {
+        std::cerr << "Sharded run failed: a shard could not be started or exited early\n";
+        return 1;
+    }
+    auto wallEnd = std::chrono::steady_clock::now();
+
+    auto report = RunReport{};
+    report.mode = "sharded x" + std::to_string(shardCount);
+    report.elapsedTime = sharded.getElapsedTime();
+    report.wallTime = std::chrono::duration<double>(wallEnd - wallStart).count();
+    report.processedFiles = sharded.getProcessedFilesCount();
+    report.averageWaitTime = report.processedFiles > 0
+        ? sharded.getTotalWaitTime() / report.processedFiles : 0.0;
+    report.p99WaitTime = sharded.getWaitTimePercentile(0.99);
+    report.hasLocality = false;
+    printReport(report);
+    std::cout << "  Cross-shard dispatches: " << sharded.getCrossShardDispatchCount() << "\n";
+    return 0;
+}
+
+void HeadlessRunner::exportTimeSeries(const Simulation& simulation, const std::string& runName) const
+{
+    auto path = outputPathFor(timeSeriesPath, runName);
+
+    auto error = std::string{};
+    bool isCsv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    bool written = isCsv
+        ? simulation.getTimeSeries().exportCsv(path, error)
+        : simulation.getTimeSeries().exportColumnar(path, error);
+
+    if (written)
+    {
+        std::cout << "Time series written to " << path << "\n";
+    } else {
+        std::cerr << "Time series export failed: " << error << "\n";
+    }
+}
+
+std::string HeadlessRunner::outputPathFor(const std::string& path, const std::string& runName) const
+{
+    // Comparison runs write one file per scheduler
+    if (mode != "compare")
+    {
+        return path;
+    }
+
+    auto dot = path.find_last_of('.');
+    auto slash = path.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        dot = path.size();
+    }
+    return path.substr(0, dot) + "-" + runName + path.substr(dot);
+}
+
+int HeadlessRunner::sweepDirectories()
+{
+    auto schedulingMode = mode == "stealing" ? SchedulingMode::WorkStealing : SchedulingMode::CentralGreedy;
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "  " << std::setw(12) << "directories" << std::setw(14) << "makespan"
+              << std::setw(14) << "avg wait" << std::setw(14) << "p99 wait"
+              << std::setw(14) << "files/sec" << "\n";
+
+    for (int directories = 1; directories <= sweepMaxDirectories; directories++)
+    {
+        auto report = runOnce(schedulingMode, directories);
+        std::cout << "  " << std::setw(12) << directories
+                  << std::setw(14) << report.elapsedTime
+                  << std::setw(14) << report.averageWaitTime
+                  << std::setw(14) << report.p99WaitTime
+                  << std::setw(14) << report.processedFiles / report.elapsedTime << "\n";
+    }
+    return 0;
+}
+
+int HeadlessRunner::sweepDedupCache()
+{
+    auto schedulingMode = mode == "stealing" ? SchedulingMode::WorkStealing : SchedulingMode::CentralGreedy;
+    auto configured = dedup;
+
+    // Every size is compared against the same workload without a cache
+    dedup.enabled = false;
+    auto uncached = runOnce(schedulingMode);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Repeat probability " << workload.repeatProbability << ", lookup "
+              << configured.lookupTime << " secs\n"
+              << "  " << std::setw(12) << "cache KB" << std::setw(10) << "hit rate"
+              << std::setw(12) << "KB saved" << std::setw(12) << "avg wait"
+              << std::setw(12) << "p99 wait" << std::setw(12) << "makespan"
+              << std::setw(14) << "wait change" << "\n";
+    std::cout << "  " << std::setw(12) << "none" << std::setw(10) << "-" << std::setw(12) << "-"
+              << std::setw(12) << uncached.averageWaitTime << std::setw(12) << uncached.p99WaitTime
+              << std::setw(12) << uncached.elapsedTime << std::setw(14) << "-" << "\n";
+
+    for (double size : dedupSweepSizes)
+    {
+        dedup = configured;
+        dedup.enabled = true;
+        dedup.capacity = size;
+        auto report = runOnce(schedulingMode);
+
+        double change = uncached.averageWaitTime > 0.0
+            ? (report.averageWaitTime - uncached.averageWaitTime) / uncached.averageWaitTime * 100.0 : 0.0;
+        std::cout << "  " << std::setw(12) << size
+                  << std::setw(9) << report.dedupHitRate * 100.0 << "%"
+                  << std::setw(12) << report.dedupSaved
+                  << std::setw(12) << report.averageWaitTime
+                  << std::setw(12) << report.p99WaitTime
+                  << std::setw(12) << report.elapsedTime
+                  << std::setw(13) << change << "%\n";
+    }
+
+    dedup = configured;
+    return 0;
+}
+
+int HeadlessRunner::runTuner()
+{
+    auto config = CapacityTuner::Config{};
+    config.workload = workload;
+    config.bandwidth = bandwidth;
+    config.pipeline = pipeline;
+    config.dedup = dedup;
+    config.steadyState = steadyState;
+    if (sessions)
+    {
+        config.behavior = runSessions;
+    }
+    config.tracePath = tracePath;
+    config.customerCount = customerCount;
+    config.sloPercentile = sloPercentile;
+    config.sloSeconds = sloSeconds;
+    config.maxDirectories = maxDirectories;
+    config.replications = replications;
+    config.parallelRuns = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    config.seed = seed;
+    if (mode == "central")
+    {
+        config.policies = {SchedulingMode::CentralGreedy};
+    } else if (mode == "stealing")
+    {
+        config.policies = {SchedulingMode::WorkStealing};
+    }
+
+    std::cout << "Tuning for p" << sloPercentile * 100.0 << " wait <= " << sloSeconds
+              << " secs, up to " << maxDirectories << " directories, "
+              << replications << " replications per candidate, "
+              << (steadyState.enabled ? "warm-up excluded" : "warm-up included") << "\n\n";
+
+    auto tuner = CapacityTuner{config};
+    auto result = tuner.run();
+
+    auto policyName = [](SchedulingMode policy)
+        {
+            return policy == SchedulingMode::WorkStealing ? "work-stealing" : "central-greedy";
+        };
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "  " << std::left << std::setw(16) << "policy" << std::right
+              << std::setw(12) << "directories" << std::setw(12) << "mean"
+              << std::setw(12) << "ci lower" << std::setw(12) << "ci upper"
+              << std::setw(12) << "bound" << "  SLO\n";
+    for (const auto& point : result.evaluated)
+    {
+        std::cout << "  " << std::left << std::setw(16) << policyName(point.policy) << std::right
+                  << std::setw(12) << point.directoryCount
+                  << std::setw(12) << point.meanPercentile
+                  << std::setw(12) << point.lowerBound
+                  << std::setw(12) << point.upperBound
+                  << std::setw(12) << point.sloBound
+                  << "  " << (point.meetsSlo ? "met" : "missed") << "\n";
+    }
+
+    if (!result.found)
+    {
+        std::cout << "\nNo configuration up to " << maxDirectories << " directories meets the SLO\n";
+        return 2;
+    }
+
+    std::cout << "\nCheapest configuration: " << result.best.directoryCount << " directories, "
+              << policyName(result.best.policy) << " (p" << std::defaultfloat << sloPercentile * 100.0
+              << std::fixed << " wait "
+              << result.best.meanPercentile << " secs, 95% CI ["
+              << result.best.lowerBound << ", " << result.best.upperBound << "], one-sided 95% upper bound "
+              << result.best.sloBound << " secs)\n";
+    return 0;
+}
+
+int HeadlessRunner::runRegression()
+{
+    auto config = RegressionHarness::Config{};
+    config.workload = workload;
+    config.customerCount = customerCount;
+    config.directoryCount = directoryCount;
+    config.seed = seed;
+    config.repetitions = replications;
+    config.threshold = regressionThreshold;
+    config.baselinePath = baselinePath;
+    config.updateBaseline = updateBaseline;
+    config.scratchDirectory = scratchDirectory;
+    if (threadCount > 1 && std::find(config.threadCounts.begin(), config.threadCounts.end(), threadCount) == config.threadCounts.end())
+    {
+        config.threadCounts.push_back(threadCount);
+    }
+    if (shardCount > 1 && std::find(config.shardCounts.begin(), config.shardCounts.end(), shardCount) == config.shardCounts.end())
+    {
+        config.shardCounts.push_back(shardCount);
+    }
+
+    if (!baselinePath.empty() && !updateBaseline && access(baselinePath.c_str(), R_OK) != 0)
+    {
+        std::cerr << "Baseline " << baselinePath << " is unreadable; create it with --update-baseline\n";
+        return 1;
+    }
+
+    auto harness = RegressionHarness{config};
+    bool passed = harness.run();
+
+    std::cout << std::fixed << std::setprecision(4)
+              << "  " << std::left << std::setw(24) << "engine" << std::right
+              << std::setw(18) << "digest" << std::setw(8) << "files"
+              << std::setw(10) << "wall" << std::setw(12) << "peak RSS" << "  result\n";
+    for (const auto& outcome : harness.getOutcomes())
+    {
+        std::cout << "  " << std::left << std::setw(24) << outcome.name << std::right
+                  << "  " << std::hex << std::setw(16) << std::setfill('0') << outcome.digest
+                  << std::dec << std::setfill(' ')
+                  << std::setw(8) << outcome.fileCount
+                  << std::setw(10) << outcome.wallTime
+                  << std::setw(9) << outcome.peakRssKb << " KB"
+                  << "  " << (outcome.failure.empty() ? "ok" : outcome.failure) << "\n";
+    }
+
+    if (!baselinePath.empty())
+    {
+        std::cout << "\n" << (updateBaseline ? "Baseline written to " : "Compared against baseline ")
+                  << baselinePath << "\n";
+    }
+    std::cout << (passed ? "All engines agree\n" : "Regression detected\n");
+    return passed ? 0 : 1;
+}
+
+void HeadlessRunner::printStages(const RunReport& report) const
+{
+    std::cout << "  End-to-end latency: mean " << report.meanLatency << " secs, p99 "
+              << report.p99Latency << " secs\n"
+              << "    " << std::left << std::setw(14) << "stage" << std::right
+              << std::setw(8) << "workers" << std::setw(10) << "files"
+              << std::setw(10) << "files/s" << std::setw(8) << "busy" << std::setw(10) << "blocked"
+              << std::setw(11) << "avg queue" << std::setw(11) << "max queue"
+              << std::setw(12) << "residence" << "\n";
+
+    // The busiest stage is the one to size up first
+    int bottleneck = 0;
+    for (int i = 1; i < static_cast<int>(report.stageStats.size()); i++)
+    {
+        if (report.stageStats[i].utilization > report.stageStats[bottleneck].utilization)
+        {
+            bottleneck = i;
+        }
+    }
+
+    for (int i = 0; i < static_cast<int>(report.stageStats.size()); i++)
+    {
+        const auto& stage = report.stageStats[i];
+        std::cout << "    " << std::left << std::setw(14) << stage.name << std::right
+                  << std::setw(8) << stage.workerCount
+                  << std::setw(10) << stage.completed
+                  << std::setw(10) << stage.throughput
+                  << std::setw(7) << stage.utilization * 100.0 << "%"
+                  << std::setw(9) << stage.blockedFraction * 100.0 << "%"
+                  << std::setw(11) << stage.meanQueueLength
+                  << std::setw(11) << stage.maxQueueLength
+                  << std::setw(12) << stage.meanResidence
+                  << (i == bottleneck ? "  <- bottleneck" : "") << "\n";
+    }
+}
+
+void HeadlessRunner::printReport(const RunReport& report) const
+{
+    std::cout << std::fixed << std::setprecision(2)
+              << "[" << report.mode << "]\n"
+              << "  Simulated time:    " << report.elapsedTime << " secs\n"
+              << "  Wall time:         " << report.wallTime << " secs\n"
+              << "  Files processed:   " << report.processedFiles << "\n"
+              << "  Average wait time: " << report.averageWaitTime << " secs\n"
+              << "  p99 wait time:     " << report.p99WaitTime << " secs\n";
+    if (report.hasLocality)
+    {
+        std::cout << "  Steals:            " << report.steals << "\n"
+                  << "  Locality:          " << report.locality * 100.0 << "%\n";
+    } else {
+        std::cout << "  Steals:            n/a\n"
+                  << "  Locality:          n/a\n";
+    }
+
+    if (report.steadyStateEnabled)
+    {
+        std::cout << "  Steady-state wait: " << report.steadyStateMean << " +/- " << report.steadyStateHalfWidth
+                  << " secs (95% CI), " << report.warmupFiles << " warm-up files before "
+                  << report.warmupTime << " secs discarded\n";
+        if (!report.steadyStateReached)
+        {
+            std::cout << "  Steady state:      requested precision not reached\n";
+        } else if (steadyState.stopWhenPrecise)
+        {
+            std::cout << "  Steady state:      reached, run stopped early\n";
+        } else {
+            std::cout << "  Steady state:      reached\n";
+        }
+    }
+
+    if (report.dedupEnabled)
+    {
+        std::cout << "  Dedup hit rate:    " << report.dedupHitRate * 100.0 << "%, "
+                  << report.dedupSaved << " KB not transferred\n";
+    }
+
+    if (!report.stageStats.empty())
+    {
+        printStages(report);
+    }
+
+    if (!profile || report.phaseStats.empty())
+    {
+        return;
+    }
+
+#if FTS_PROFILING
+    std::cout << "  Phase profile (last " << PhaseHistogram::WindowSize << " ticks, microseconds):\n"
+              << "    " << std::left << std::setw(18) << "phase" << std::right
+              << std::setw(10) << "samples" << std::setw(10) << "mean"
+              << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    for (int i = 0; i < static_cast<int>(report.phaseStats.size()); i++)
+    {
+        const auto& stats = report.phaseStats[i];
+        std::cout << "    " << std::left << std::setw(18) << profilePhaseName(static_cast<ProfilePhase>(i)) << std::right
+                  << std::setw(10) << stats.totalSamples
+                  << std::setw(10) << stats.meanNs / 1000.0
+                  << std::setw(10) << stats.p50Ns / 1000.0
+                  << std::setw(10) << stats.p99Ns / 1000.0
+                  << std::setw(10) << stats.maxNs / 1000.0 << "\n";
+    }
+#else
+    std::cout << "  Phase profile unavailable: built with FTS_PROFILING=0\n";
+#endif
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "WorkloadSpec.hpp"
+#include <string>
+
+class HeadlessRunner
+{
+public:
+    HeadlessRunner(int argc, char* argv[]);
+
+    static bool isRequested(int argc, char* argv[]);
+    int run();
+
+private:
+    struct RunReport
+    {
+        std::string mode;
+        double elapsedTime;
+        double wallTime;
+        int processedFiles;
+        double averageWaitTime;
+        double p99WaitTime;
+        int steals;
+        double locality;
+        // False when the engine has no per-directory queues to steal from
+        bool hasLocality;
+        std::vector<PhaseStats> phaseStats;
+        std::vector<StageStats> stageStats;
+        double meanLatency;
+        double p99Latency;
+        bool dedupEnabled;
+        double dedupHitRate;
+        double dedupSaved;
+        bool steadyStateEnabled;
+        bool steadyStateReached;
+        double steadyStateMean;
+        double steadyStateHalfWidth;
+        long long warmupFiles;
+        double warmupTime;
+    };
+
+    RunReport runOnce(SchedulingMode mode);
+    RunReport runOnce(SchedulingMode mode, int directories);
+    void configureSimulation(Simulation& simulation, SchedulingMode mode) const;
+    RunReport reportFor(const Simulation& simulation, SchedulingMode mode, double wallTime) const;
+    int runServer();
+    int runSharded();
+    int runTuner();
+    int runRegression();
+    bool addVerifyStage();
+    int convertTrace();
+    int sweepDirectories();
+    int sweepDedupCache();
+    void exportTimeSeries(const Simulation& simulation, const std::string& runName) const;
+    std::string outputPathFor(const std::string& path, const std::string& runName) const;
+    void printReport(const RunReport& report) const;
+    void printStages(const RunReport& report) const;
+
+    int customerCount;
+    int directoryCount;
+    int threadCount;
+    int shardCount;
+    unsigned int seed;
+    bool sessions;
+    bool profile;
+    bool tune;
+    bool regress;
+    bool verify;
+    int calibrationMegabytes;
+    bool updateBaseline;
+    double regressionThreshold;
+    double serveSpeed;
+    double sloSeconds;
+    double sloPercentile;
+    int maxDirectories;
+    int replications;
+    int sweepMaxDirectories;
+    WorkloadSpec workload;
+    BandwidthConfig bandwidth;
+    PipelineConfig pipeline;
+    DedupConfig dedup;
+    SteadyStateConfig steadyState;
+    std::vector<double> dedupSweepSizes;
+    std::string tracePath;
+    std::string timeSeriesPath;
+    std::string resultsPath;
+    std::string baselinePath;
+    std::string scratchDirectory;
+    std::string servePath;
+    std::string convertInputPath;
+    std::string convertOutputPath;
+    std::string mode;
+};
@@ -1,11 +1,26 @@
 #include "MainWindow.hpp"
 #include "Simulation.hpp"
 
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
 #include <QMessageBox>
+#include <QSignalBlocker>
+#include <QStatusBar>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
+namespace
+{
+    // Render rate of the GUI, independent of the simulation step rate
+    constexpr int RefreshIntervalMs = 16;
+    constexpr const char* DefaultSocketPath = "/tmp/fts.sock";
+}
+
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), updateTimer(nullptr)
+    : QMainWindow(parent), updateTimer(nullptr), attachPath(DefaultSocketPath), remote(false)
 {
     setWindowTitle("File Transfer Simulation");
     resize(1000, 700);
@@ -16,15 +31,28 @@ MainWindow::MainWindow(QWidget *parent)
     
     updateTimer = new QTimer(this);
     connect(updateTimer, &QTimer::timeout, this, &MainWindow::updateGUI);
+
+    snapshotClient = new SnapshotClient(this);
+    connect(snapshotClient, &SnapshotClient::attached, this, &MainWindow::remoteAttached);
+    connect(snapshotClient, &SnapshotClient::detached, this, &MainWindow::remoteDetached);
 }
 
 MainWindow::~MainWindow()
 {
+    // The socket reports its teardown through signals this window can no
+    // longer handle once it is being destroyed
+    disconnect(snapshotClient, nullptr, this, nullptr);
+
     if (updateTimer) {
         updateTimer->stop();
         delete updateTimer;
     }
-    
+
+    // The simulation thread records into the writer until it stops
+    if (simulation) {
+        simulation->stop();
+    }
+    finishResults();
 }
 
 void MainWindow::setupUI()
@@ -41,28 +69,24 @@ void MainWindow::setupUI()
     createCustomersUI();
     
     createStatusUI();
+
+    createChartsUI();
+
+    createProfilingUI();
 }
 
 void MainWindow::createDirectoriesUI()
 {
     directoriesGroupBox = new QGroupBox("CPU Directories (5)");
-    directoriesLayout = new QGridLayout(directoriesGroupBox);
+    directoriesLayout = new QVBoxLayout(directoriesGroupBox);
     
+    directoryBoard = new DirectoryBoard();
+    auto initialDirectories = std::vector<DirectorySnapshot>{};
     for (int i = 0; i < 5; i++) {
-        auto directoryLabel = new QLabel(QString("Directory %1").arg(i + 1));
-        auto progressBar = new QProgressBar();
-        progressBar->setRange(0, 100);
-        progressBar->setValue(0);
-        auto statusLabel = new QLabel("Idle");
-        
-        directoryLabels.push_back(directoryLabel);
-        directoryProgressBars.push_back(progressBar);
-        directoryStatusLabels.push_back(statusLabel);
-        
-        directoriesLayout->addWidget(directoryLabel, i, 0);
-        directoriesLayout->addWidget(progressBar, i, 1);
-        directoriesLayout->addWidget(statusLabel, i, 2);
+        initialDirectories.push_back(DirectorySnapshot{i + 1, false, 0, 0, 0, 0});
     }
+    directoryBoard->setDirectories(initialDirectories);
+    directoriesLayout->addWidget(directoryBoard);
     
     mainLayout->addWidget(directoriesGroupBox);
 }
@@ -79,28 +103,69 @@ void MainWindow::createControlsUI()
     pauseButton->setEnabled(false);
     stopButton->setEnabled(false);
     
-    speedLabel = new QLabel("Speed:");
+    speedLabel = new QLabel("Speed: 1.0x");
     speedSlider = new QSlider(Qt::Horizontal);
-    speedSlider->setRange(1, 10);
-    speedSlider->setValue(5);
+    speedSlider->setRange(0, 50);
+    speedSlider->setValue(10);
+    unthrottledCheckBox = new QCheckBox("Unthrottled");
     
     customersLabel = new QLabel("Customers:");
     customersSpinBox = new QSpinBox();
     customersSpinBox->setRange(1, 1000);
     customersSpinBox->setValue(10);
+
+    schedulingLabel = new QLabel("Scheduler:");
+    schedulingComboBox = new QComboBox();
+    schedulingComboBox->addItem("Central greedy");
+    schedulingComboBox->addItem("Work stealing");
+
+    threadsLabel = new QLabel("Threads:");
+    threadsSpinBox = new QSpinBox();
+    threadsSpinBox->setRange(1, std::max(1, QThread::idealThreadCount()));
+    threadsSpinBox->setValue(1);
+
+    sessionsCheckBox = new QCheckBox("Closed-loop sessions");
+
+    addDirectoryButton = new QPushButton("+ Directory");
+    removeDirectoryButton = new QPushButton("- Directory");
+    burstButton = new QPushButton("Inject Burst");
+    addDirectoryButton->setEnabled(false);
+    removeDirectoryButton->setEnabled(false);
+    burstButton->setEnabled(false);
+    resultsButton = new QPushButton("Record Results...");
+    attachButton = new QPushButton("Attach...");
     
     connect(startButton, &QPushButton::clicked, this, &MainWindow::startSimulation);
     connect(pauseButton, &QPushButton::clicked, this, &MainWindow::pauseSimulation);
     connect(stopButton, &QPushButton::clicked, this, &MainWindow::stopSimulation);
     connect(speedSlider, &QSlider::valueChanged, this, &MainWindow::updateSimulationSpeed);
+    connect(unthrottledCheckBox, &QCheckBox::toggled, this, &MainWindow::toggleUnthrottled);
+    connect(addDirectoryButton, &QPushButton::clicked, this, &MainWindow::addDirectory);
+    connect(removeDirectoryButton, &QPushButton::clicked, this, &MainWindow::removeDirectory);
+    connect(burstButton, &QPushButton::clicked, this, &MainWindow::injectBurst);
+    connect(resultsButton, &QPushButton::clicked, this, &MainWindow::chooseResultsFile);
+    connect(attachButton, &QPushButton::clicked, this, &MainWindow::toggleAttach);
+    connect(schedulingComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+        this, &MainWindow::changeSchedulingPolicy);
     
     controlsLayout->addWidget(startButton);
     controlsLayout->addWidget(pauseButton);
     controlsLayout->addWidget(stopButton);
     controlsLayout->addWidget(speedLabel);
     controlsLayout->addWidget(speedSlider);
+    controlsLayout->addWidget(unthrottledCheckBox);
     controlsLayout->addWidget(customersLabel);
     controlsLayout->addWidget(customersSpinBox);
+    controlsLayout->addWidget(schedulingLabel);
+    controlsLayout->addWidget(schedulingComboBox);
+    controlsLayout->addWidget(threadsLabel);
+    controlsLayout->addWidget(threadsSpinBox);
+    controlsLayout->addWidget(sessionsCheckBox);
+    controlsLayout->addWidget(addDirectoryButton);
+    controlsLayout->addWidget(removeDirectoryButton);
+    controlsLayout->addWidget(burstButton);
+    controlsLayout->addWidget(resultsButton);
+    controlsLayout->addWidget(attachButton);
     
     mainLayout->addWidget(controlsGroupBox);
 }
@@ -136,48 +201,123 @@ void MainWindow::createStatusUI()
     timeElapsedLabel = new QLabel("Time Elapsed: 0 secs");
     filesProcessedLabel = new QLabel("Files Processed: 0");
     simulationStatusLabel = new QLabel("Status: Ready");
+    schedulingStatsLabel = new QLabel("Steals: 0, Locality: 100%");
+    speedStatusLabel = new QLabel("Speed: -");
     
     statusHLayout->addWidget(timeElapsedLabel);
     statusHLayout->addWidget(filesProcessedLabel);
     statusHLayout->addWidget(simulationStatusLabel);
+    statusHLayout->addWidget(schedulingStatsLabel);
+    statusHLayout->addWidget(speedStatusLabel);
     
     statusLayout->addLayout(statusHLayout);
     
     mainLayout->addWidget(statusGroupBox);
 }
 
+void MainWindow::createChartsUI()
+{
+    chartsGroupBox = new QGroupBox("Trends");
+    chartsLayout = new QVBoxLayout(chartsGroupBox);
+
+    timeSeriesChart = new TimeSeriesChart();
+    chartsLayout->addWidget(timeSeriesChart);
+
+    mainLayout->addWidget(chartsGroupBox);
+}
+
+void MainWindow::createProfilingUI()
+{
+    profilingGroupBox = new QGroupBox("Profiling (per tick, microseconds)");
+    profilingLayout = new QGridLayout(profilingGroupBox);
+
+    const char* headers[] = {"Phase", "Mean", "p50", "p99", "Max"};
+    for (int column = 0; column < 5; column++) {
+        profilingLayout->addWidget(new QLabel(QString("<b>%1</b>").arg(headers[column])), 0, column);
+    }
+
+    for (int phase = 0; phase < static_cast<int>(ProfilePhase::Count); phase++) {
+        profilingLayout->addWidget(new QLabel(profilePhaseName(static_cast<ProfilePhase>(phase))), phase + 1, 0);
+        for (int column = 1; column < 5; column++) {
+            auto valueLabel = new QLabel("-");
+            profilingLabels.push_back(valueLabel);
+            profilingLayout->addWidget(valueLabel, phase + 1, column);
+        }
+    }
+
+#if !FTS_PROFILING
+    profilingGroupBox->setTitle("Profiling (disabled in this build)");
+#endif
+
+    mainLayout->addWidget(profilingGroupBox);
+}
+
 void MainWindow::startSimulation()
 {
     if (!simulation) return;
 
     if (simulation->isRunning())
     {
-        simulation->resume();
+        if (!simulation->resume())
+        {
+            reportRejectedCommand("Resume");
+            return;
+        }
     } else {
         simulation->reset();
-        simulation->initialize(customersSpinBox->value());
-        simulation->start();
-        customersList->clear();
+        simulation->setSchedulingMode(schedulingComboBox->currentIndex() == 1
+            ? SchedulingMode::WorkStealing : SchedulingMode::CentralGreedy);
+        simulation->setThreadCount(threadsSpinBox->value());
+        simulation->setCustomerBehavior(sessionsCheckBox->isChecked() ? CustomerBehavior{runSessions} : CustomerBehavior{});
 
-        for (int i = 0; i < simulation->getCustomersCount(); i++)
+        finishResults();
+        if (!resultsPath.isEmpty())
         {
-            customersList->addItem(QString("Customer %1").arg(i + 1));
+            resultWriter = std::make_unique<ResultWriter>();
+            auto error = std::string{};
+            if (!resultWriter->open(resultsPath.toStdString(), error))
+            {
+                QMessageBox::warning(this, "Record Results", QString::fromStdString(error));
+                resultWriter.reset();
+            }
         }
+        auto writer = resultWriter.get();
+        simulation->setCompletionObserver(writer
+            ? CompletionObserver{[writer](const FileResult& result) { writer->record(result); }}
+            : CompletionObserver{});
+
+        // The customer list and details are filled from snapshots
+        simulation->setPublishCustomers(true);
+        simulation->initialize(customersSpinBox->value());
+        simulation->start();
+        customersList->clear();
+        timeSeriesChart->clear();
     }
 
     startButton->setEnabled(false);
     pauseButton->setEnabled(true);
     stopButton->setEnabled(true);
     customersSpinBox->setEnabled(false);
+    threadsSpinBox->setEnabled(false);
+    sessionsCheckBox->setEnabled(false);
+    resultsButton->setEnabled(false);
+    attachButton->setEnabled(false);
+    addDirectoryButton->setEnabled(true);
+    removeDirectoryButton->setEnabled(true);
+    burstButton->setEnabled(true);
     simulationStatusLabel->setText("Status: Running");
-    updateTimer->start(100);
+    updateTimer->start(RefreshIntervalMs);
 }
 
 void MainWindow::pauseSimulation()
 {
     if (!simulation) return;
 
-    simulation->pause();
+    if (!simulation->pause())
+    {
+        reportRejectedCommand("Pause");
+        return;
+    }
 
     startButton->setEnabled(true);
     pauseButton->setEnabled(false);
@@ -191,89 +331,292 @@ void MainWindow::stopSimulation()
     if (!simulation) return;
 
     simulation->stop();
+    finishResults();
     startButton->setEnabled(true);
     pauseButton->setEnabled(false);
     stopButton->setEnabled(false);
     customersSpinBox->setEnabled(true);
+    threadsSpinBox->setEnabled(true);
+    sessionsCheckBox->setEnabled(true);
+    resultsButton->setEnabled(true);
+    attachButton->setEnabled(true);
+    addDirectoryButton->setEnabled(false);
+    removeDirectoryButton->setEnabled(false);
+    burstButton->setEnabled(false);
     simulationStatusLabel->setText("Status: Stopped");
 
     updateTimer->stop();
-    for (auto progressBar : directoryProgressBars) {
-        progressBar->setValue(0);
-    }
-    for (auto statusLabel : directoryStatusLabels) {
-        statusLabel->setText("Idle");
-    }
+    directoryBoard->clearActivity();
 }
 
 void MainWindow::updateGUI()
 {
-    if (!simulation || !simulation->isRunning()) return;
+    if (!simulation) return;
 
-    for (int i = 0; i < 5; i++) {
-        auto dir = simulation->getDirectory(i);
-        directoryProgressBars[i]->setValue(dir.getProgress());
-        
-        if (dir.isProcessing()) {
-            auto customer = dir.getCurrentCustomer();
-            auto file = dir.getCurrentFile();
-            if (customer && file) {
-                directoryStatusLabels[i]->setText(QString("Customer %1, File %2, %3KB")
-                    .arg(customer->getId())
-                    .arg(file->getId())
-                    .arg(file->getSize()));
-            }
-        } else {
-            directoryStatusLabels[i]->setText("Idle");
+    auto snapshot = remote ? snapshotClient->getSnapshot() : simulation->getSnapshot();
+    if (!snapshot) return;
+
+    directoryBoard->setDirectories(snapshot->directories);
+    directoriesGroupBox->setTitle(QString("CPU Directories (%1)").arg(snapshot->directories.size()));
+
+    timeElapsedLabel->setText(QString("Time Elapsed: %1 secs").arg(snapshot->elapsedTime));
+    filesProcessedLabel->setText(QString("Files Processed: %1").arg(snapshot->processedFiles));
+    schedulingStatsLabel->setText(QString("Steals: %1, Locality: %2%")
+        .arg(snapshot->stealCount)
+        .arg(snapshot->locality * 100.0, 0, 'f', 1));
+
+    auto requested = snapshot->requestedSpeed == Simulation::Unthrottled
+        ? QString("unthrottled")
+        : QString("%1x").arg(snapshot->requestedSpeed, 0, 'g', 3);
+    speedStatusLabel->setText(QString("Speed: %1x of %2%3")
+        .arg(snapshot->achievedSpeed, 0, 'g', 3)
+        .arg(requested)
+        .arg(snapshot->overloaded ? " (overloaded)" : ""));
+
+    timeSeriesChart->setSeries(snapshot->timeSeries);
+
+    for (int phase = 0; phase < static_cast<int>(snapshot->phaseStats.size()); phase++) {
+        const auto& stats = snapshot->phaseStats[phase];
+        const double values[] = {stats.meanNs, stats.p50Ns, stats.p99Ns, stats.maxNs};
+        for (int column = 0; column < 4; column++) {
+            profilingLabels[phase * 4 + column]->setText(QString::number(values[column] / 1000.0, 'f', 1));
         }
     }
 
-    timeElapsedLabel->setText(QString("Time Elapsed: %1 secs").arg(simulation->getElapsedTime()));
-    filesProcessedLabel->setText(QString("Files Processed: %1").arg(simulation->getProcessedFilesCount()));
+    // Trace replays add customers as they arrive
+    int customerCount = static_cast<int>(snapshot->customers.size());
+    while (customersList->count() < customerCount) {
+        customersList->addItem(QString("Customer %1").arg(snapshot->customers[customersList->count()].id));
+    }
+    while (customersList->count() > customerCount) {
+        delete customersList->takeItem(customersList->count() - 1);
+    }
 
     int currentRow = customersList->currentRow();
-    if (currentRow >= 0 && currentRow < simulation->getCustomersCount()) {
+    if (currentRow >= 0 && currentRow < customerCount) {
         showCustomerDetails(currentRow);
     }
 
-    if (simulation->isCompleted()) {
+    if (remote) {
+        // The server owns the run; it closes the connection itself once done
+        simulationStatusLabel->setText(snapshot->completed ? "Status: Remote run complete" : "Status: Attached");
+    } else if (snapshot->completed) {
+        stopSimulation();
         QMessageBox::information(this, "Simulation Complete", 
             "All files have been processed!\n\n"
-            "Total files processed: " + QString::number(simulation->getProcessedFilesCount()) + "\n"
-            "Average wait time: " + QString::number(simulation->getTotalWaitTime() / simulation->getProcessedFilesCount(), 'f', 2) + " secs");
-        stopSimulation();
+            "Total files processed: " + QString::number(snapshot->processedFiles) + "\n"
+            "Average wait time: " + QString::number(snapshot->totalWaitTime / snapshot->processedFiles, 'f', 2) + " secs");
     }
 }
 
 void MainWindow::showCustomerDetails(int customerIndex)
 {
-    if (!simulation || customerIndex < 0 || customerIndex >= simulation->getCustomersCount()) {
+    if (!simulation) return;
+
+    // Customers belong to the simulation thread, so details come from its
+    // snapshots; a new selection shows up in the next one
+    auto snapshot = remote ? snapshotClient->getSnapshot() : simulation->getSnapshot();
+    if (!remote && snapshot && snapshot->detailCustomer != customerIndex) {
+        simulation->setDetailCustomer(customerIndex);
+        snapshot = simulation->getSnapshot();
+    }
+
+    if (!snapshot || customerIndex < 0 || customerIndex >= static_cast<int>(snapshot->customers.size())) {
         customerDetailsText->clear();
         return;
     }
-    
-    const auto& customer = simulation->getCustomer(customerIndex);
-    
+
+    const auto& customer = snapshot->customers[customerIndex];
+
     std::stringstream ss;
-    ss << "Customer " << customer.getId() << " Details:\n";
+    ss << "Customer " << customer.id << " Details:\n";
     ss << "------------------------\n";
-    ss << "Pending Files: " << customer.getPendingFilesCount() << "\n";
-    ss << "Processed Files: " << customer.getProcessedFilesCount() << "\n";
-    ss << "Total Files: " << customer.getTotalFilesCount() << "\n";
-    ss << "Wait Time: " << customer.getTotalWaitTime() << " secs\n\n";
-    
-    ss << "Pending Files:\n";
-    for (int i = 0; i < customer.getPendingFilesCount(); i++) {
-        const auto& file = customer.getPendingFile(i);
-        ss << "- File " << file.getId() << ": " << file.getSize() << "KB, Priority: " 
-            << file.getPriority() << ", Wait Time: " << file.getWaitTime() << " secs\n";
+    ss << "Pending Files: " << customer.pendingFiles << "\n";
+    ss << "Processed Files: " << customer.processedFiles << "\n";
+    ss << "Total Files: " << customer.pendingFiles + customer.processedFiles << "\n";
+    ss << "Wait Time: " << customer.totalWaitTime << " secs\n\n";
+
+    if (snapshot->detailCustomer == customerIndex) {
+        ss << "Pending Files:\n";
+        for (const auto& file : snapshot->detailFiles) {
+            ss << "- File " << file.id << ": " << file.size << "KB, Priority: "
+                << file.priority << ", Wait Time: " << file.waitTime << " secs\n";
+        }
+    } else if (remote) {
+        ss << "Per-file details are only available for local runs.\n";
     }
-    
+
     customerDetailsText->setText(QString::fromStdString(ss.str()));
 }
 
 void MainWindow::updateSimulationSpeed(int value)
+{
+    speedLabel->setText(QString("Speed: %1x").arg(speedFactorForSlider(value), 0, 'g', 3));
+
+    if (!simulation || unthrottledCheckBox->isChecked()) return;
+    if (!simulation->setSpeed(speedFactorForSlider(value)))
+    {
+        reportRejectedCommand("Speed change");
+    }
+}
+
+void MainWindow::toggleUnthrottled(bool checked)
+{
+    speedSlider->setEnabled(!checked);
+
+    if (!simulation) return;
+    if (!simulation->setSpeed(checked ? Simulation::Unthrottled : speedFactorForSlider(speedSlider->value())))
+    {
+        reportRejectedCommand("Speed change");
+
+        // Show the pacing that is still in effect
+        auto blocker = QSignalBlocker{unthrottledCheckBox};
+        unthrottledCheckBox->setChecked(!checked);
+        speedSlider->setEnabled(checked);
+    }
+}
+
+void MainWindow::addDirectory()
+{
+    if (!simulation) return;
+    sendCommand(SimulationCommand{CommandType::AddDirectory}, "Add directory");
+}
+
+void MainWindow::removeDirectory()
+{
+    if (!simulation) return;
+    sendCommand(SimulationCommand{CommandType::RemoveDirectory}, "Remove directory");
+}
+
+void MainWindow::injectBurst()
 {
     if (!simulation) return;
-    simulation->setSpeed(value);
-}
\ No newline at end of file
+
+    auto command = SimulationCommand{CommandType::InjectBurst};
+    command.fileCount = customersSpinBox->value() * 5;
+    sendCommand(command, "Burst");
+}
+
+void MainWindow::changeSchedulingPolicy(int index)
+{
+    if (!simulation || !simulation->isRunning()) return;
+
+    auto command = SimulationCommand{CommandType::SetPolicy};
+    command.policy = index == 1 ? SchedulingMode::WorkStealing : SchedulingMode::CentralGreedy;
+    if (!sendCommand(command, "Policy change"))
+    {
+        // Show the policy that is still in effect
+        auto blocker = QSignalBlocker{schedulingComboBox};
+        schedulingComboBox->setCurrentIndex(index == 1 ? 0 : 1);
+    }
+}
+
+bool MainWindow::sendCommand(const SimulationCommand& command, const QString& action)
+{
+    if (simulation->postCommand(command)) return true;
+
+    reportRejectedCommand(action);
+    return false;
+}
+
+void MainWindow::reportRejectedCommand(const QString& action)
+{
+    statusBar()->showMessage(
+        QString("%1 was not applied: the simulation is not keeping up with commands").arg(action), 5000);
+}
+
+double MainWindow::speedFactorForSlider(int value) const
+{
+    // Logarithmic scale: 0 -> 0.1x, 10 -> 1x, 50 -> 10,000x
+    return std::pow(10.0, value / 10.0 - 1.0);
+}
+
+void MainWindow::chooseResultsFile()
+{
+    auto path = QFileDialog::getSaveFileName(this, "Record Results", resultsPath,
+        "Result files (*.fts);;All files (*)");
+
+    // Cancelling the dialog turns recording off
+    resultsPath = path;
+    resultsButton->setText(resultsPath.isEmpty()
+        ? QString("Record Results...")
+        : QString("Recording: %1").arg(QFileInfo(resultsPath).fileName()));
+}
+
+void MainWindow::finishResults()
+{
+    if (!resultWriter) return;
+
+    auto error = std::string{};
+    if (resultWriter->close(error))
+    {
+        auto message = QString("Wrote %1 file results to %2").arg(resultWriter->getRowCount()).arg(resultsPath);
+        if (resultWriter->getDroppedCount() > 0)
+        {
+            message += QString(" (%1 dropped)").arg(resultWriter->getDroppedCount());
+        }
+        statusBar()->showMessage(message);
+    } else {
+        statusBar()->showMessage(QString("Recording results failed: %1").arg(QString::fromStdString(error)));
+    }
+    resultWriter.reset();
+}
+
+void MainWindow::toggleAttach()
+{
+    if (remote) {
+        snapshotClient->detach();
+        return;
+    }
+
+    bool accepted = false;
+    auto path = QInputDialog::getText(this, "Attach to Server", "Socket path:", QLineEdit::Normal, attachPath, &accepted);
+    if (!accepted || path.isEmpty()) return;
+
+    attachPath = path;
+    remote = true;
+    setLocalControlsEnabled(false);
+    attachButton->setText("Detach");
+    customersList->clear();
+    customerDetailsText->clear();
+    timeSeriesChart->clear();
+    simulationStatusLabel->setText("Status: Attaching");
+
+    snapshotClient->attach(attachPath);
+    updateTimer->start(RefreshIntervalMs);
+}
+
+void MainWindow::remoteAttached()
+{
+    statusBar()->showMessage(QString("Attached to %1").arg(attachPath));
+}
+
+void MainWindow::remoteDetached(const QString& reason)
+{
+    if (!remote) return;
+
+    // Render whatever arrived last before going back to local mode
+    updateGUI();
+    remote = false;
+    updateTimer->stop();
+    directoryBoard->clearActivity();
+    setLocalControlsEnabled(true);
+    attachButton->setText("Attach...");
+    if (simulationStatusLabel->text() != "Status: Remote run complete") {
+        simulationStatusLabel->setText("Status: Detached");
+    }
+    statusBar()->showMessage(QString("Detached from %1: %2").arg(attachPath).arg(reason));
+}
+
+void MainWindow::setLocalControlsEnabled(bool enabled)
+{
+    // Only called while the local simulation is stopped
+    startButton->setEnabled(enabled);
+    speedSlider->setEnabled(enabled && !unthrottledCheckBox->isChecked());
+    unthrottledCheckBox->setEnabled(enabled);
+    customersSpinBox->setEnabled(enabled);
+    schedulingComboBox->setEnabled(enabled);
+    threadsSpinBox->setEnabled(enabled);
+    sessionsCheckBox->setEnabled(enabled);
+    resultsButton->setEnabled(enabled);
+}
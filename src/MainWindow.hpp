@@ -1,10 +1,13 @@
 #pragma once
 
+#include "DirectoryBoard.hpp"
+#include "ResultWriter.hpp"
 #include "Simulation.hpp"
+#include "SnapshotClient.hpp"
+#include "TimeSeriesChart.hpp"
 #include <QMainWindow>
 #include <QLabel>
 #include <QPushButton>
-#include <QProgressBar>
 #include <QListWidget>
 #include <QGroupBox>
 #include <QVBoxLayout>
@@ -12,8 +15,11 @@
 #include <QGridLayout>
 #include <QSlider>
 #include <QSpinBox>
+#include <QComboBox>
+#include <QCheckBox>
 #include <QTimer>
 #include <QTextEdit>
+#include <memory>
 #include <vector>
 
 class MainWindow : public QMainWindow
@@ -31,6 +37,15 @@ private slots:
     void updateGUI();
     void showCustomerDetails(int customerIndex);
     void updateSimulationSpeed(int value);
+    void toggleUnthrottled(bool checked);
+    void addDirectory();
+    void removeDirectory();
+    void injectBurst();
+    void changeSchedulingPolicy(int index);
+    void chooseResultsFile();
+    void toggleAttach();
+    void remoteAttached();
+    void remoteDetached(const QString& reason);
 
     private:
     void setupUI();
@@ -38,6 +53,14 @@ private slots:
     void createControlsUI();
     void createCustomersUI();
     void createStatusUI();
+    void createProfilingUI();
+    void createChartsUI();
+    double speedFactorForSlider(int value) const;
+    void finishResults();
+    void setLocalControlsEnabled(bool enabled);
+    // Posts a command and reports in the status bar if the queue was full
+    bool sendCommand(const SimulationCommand& command, const QString& action);
+    void reportRejectedCommand(const QString& action);
     
     Simulation* simulation;
     QTimer *updateTimer;
@@ -46,10 +69,8 @@ private slots:
     QVBoxLayout *mainLayout;
     
     QGroupBox *directoriesGroupBox;
-    QGridLayout *directoriesLayout;
-    std::vector<QLabel*> directoryLabels;
-    std::vector<QProgressBar*> directoryProgressBars;
-    std::vector<QLabel*> directoryStatusLabels;
+    QVBoxLayout *directoriesLayout;
+    DirectoryBoard *directoryBoard;
     
     QGroupBox *controlsGroupBox;
     QHBoxLayout *controlsLayout;
@@ -58,8 +79,25 @@ private slots:
     QPushButton *stopButton;
     QSlider *speedSlider;
     QLabel *speedLabel;
+    QCheckBox *unthrottledCheckBox;
     QSpinBox *customersSpinBox;
     QLabel *customersLabel;
+    QLabel *schedulingLabel;
+    QComboBox *schedulingComboBox;
+    QLabel *threadsLabel;
+    QSpinBox *threadsSpinBox;
+    QCheckBox *sessionsCheckBox;
+    QPushButton *addDirectoryButton;
+    QPushButton *removeDirectoryButton;
+    QPushButton *burstButton;
+    QPushButton *resultsButton;
+    QString resultsPath;
+    std::unique_ptr<ResultWriter> resultWriter;
+    QPushButton *attachButton;
+    QString attachPath;
+    SnapshotClient *snapshotClient;
+    // Rendering a server's snapshots instead of the local simulation
+    bool remote;
     
     QGroupBox *customersGroupBox;
     QVBoxLayout *customersLayout;
@@ -71,4 +109,14 @@ private slots:
     QLabel *timeElapsedLabel;
     QLabel *filesProcessedLabel;
     QLabel *simulationStatusLabel;
+    QLabel *schedulingStatsLabel;
+    QLabel *speedStatusLabel;
+
+    QGroupBox *chartsGroupBox;
+    QVBoxLayout *chartsLayout;
+    TimeSeriesChart *timeSeriesChart;
+
+    QGroupBox *profilingGroupBox;
+    QGridLayout *profilingLayout;
+    std::vector<QLabel*> profilingLabels;
 };
\ No newline at end of file
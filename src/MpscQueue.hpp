@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free multi-producer single-consumer queue (Vyukov's sequenced
+// ring). Producers never block: tryPush fails when the queue is full.
+// Capacity must be a power of two.
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue(std::size_t capacity)
+        : cells(new Cell[capacity]), mask(capacity - 1), enqueuePosition(0), dequeuePosition(0)
+    {
+        for (std::size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    bool tryPush(const T& value)
+    {
+        auto position = enqueuePosition.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+
+        while (true) {
+            cell = &cells[position & mask];
+            auto sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; must only be called from one thread
+    bool tryPop(T& value)
+    {
+        auto& cell = cells[dequeuePosition & mask];
+        auto sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(dequeuePosition + 1) < 0) {
+            return false;
+        }
+
+        value = cell.value;
+        cell.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+        dequeuePosition++;
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    std::size_t mask;
+    alignas(64) std::atomic<std::size_t> enqueuePosition;
+    alignas(64) std::size_t dequeuePosition;
+};
@@ -0,0 +1,137 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+const char* profilePhaseName(ProfilePhase phase)
+{
+    switch (phase) {
+    case ProfilePhase::WaitUpdate: return "Wait update";
+    case ProfilePhase::PriorityUpdate: return "Priority update";
+    case ProfilePhase::DirectoryUpdate: return "Directory update";
+    case ProfilePhase::AssignFiles: return "Assign files";
+    case ProfilePhase::Aggregation: return "Aggregation";
+    case ProfilePhase::SnapshotPublish: return "Snapshot publish";
+    case ProfilePhase::Count: break;
+    }
+    return "Unknown";
+}
+
+PhaseHistogram::PhaseHistogram()
+{
+    reset();
+}
+
+void PhaseHistogram::record(std::uint64_t nanoseconds)
+{
+    if (windowSamples == WindowSize) {
+        auto evicted = samples[nextSample];
+        buckets[bucketFor(evicted)]--;
+        windowSum -= evicted;
+    } else {
+        windowSamples++;
+    }
+
+    samples[nextSample] = nanoseconds;
+    buckets[bucketFor(nanoseconds)]++;
+    windowSum += nanoseconds;
+    totalSamples++;
+    nextSample = (nextSample + 1) % WindowSize;
+}
+
+void PhaseHistogram::reset()
+{
+    samples.fill(0);
+    buckets.fill(0);
+    nextSample = 0;
+    windowSamples = 0;
+    windowSum = 0;
+    totalSamples = 0;
+}
+
+PhaseStats PhaseHistogram::getStats() const
+{
+    auto stats = PhaseStats{totalSamples, windowSamples, 0.0, 0.0, 0.0, 0.0};
+    if (windowSamples == 0) {
+        return stats;
+    }
+
+    std::uint64_t maxSample = 0;
+    for (int i = 0; i < windowSamples; i++) {
+        maxSample = std::max(maxSample, samples[i]);
+    }
+
+    stats.meanNs = static_cast<double>(windowSum) / windowSamples;
+    stats.p50Ns = percentile(0.50);
+    stats.p99Ns = percentile(0.99);
+    stats.maxNs = static_cast<double>(maxSample);
+    return stats;
+}
+
+int PhaseHistogram::bucketFor(std::uint64_t nanoseconds)
+{
+    if (nanoseconds < SubBuckets) {
+        return static_cast<int>(nanoseconds);
+    }
+
+    int exponent = std::bit_width(nanoseconds) - 1;
+    int subBucket = static_cast<int>((nanoseconds >> (exponent - 2)) & (SubBuckets - 1));
+    return exponent * SubBuckets + subBucket;
+}
+
+double PhaseHistogram::bucketUpperBound(int bucket)
+{
+    if (bucket < SubBuckets) {
+        return bucket;
+    }
+
+    int exponent = bucket / SubBuckets;
+    int subBucket = bucket % SubBuckets;
+    return std::ldexp(1.0 + (subBucket + 1) / static_cast<double>(SubBuckets), exponent);
+}
+
+double PhaseHistogram::percentile(double fraction) const
+{
+    auto target = static_cast<std::uint64_t>(std::ceil(fraction * windowSamples));
+    std::uint64_t seen = 0;
+    for (int bucket = 0; bucket < BucketCount; bucket++) {
+        seen += buckets[bucket];
+        if (seen >= target) {
+            return bucketUpperBound(bucket);
+        }
+    }
+    return bucketUpperBound(BucketCount - 1);
+}
+
+void Profiler::record(ProfilePhase phase, std::uint64_t nanoseconds)
+{
+    histograms[static_cast<int>(phase)].record(nanoseconds);
+}
+
+void Profiler::reset()
+{
+    for (auto& histogram : histograms) {
+        histogram.reset();
+    }
+}
+
+std::vector<PhaseStats> Profiler::getStats() const
+{
+    auto stats = std::vector<PhaseStats>{};
+    for (auto& histogram : histograms) {
+        stats.push_back(histogram.getStats());
+    }
+    return stats;
+}
+
+ScopedPhaseTimer::ScopedPhaseTimer(Profiler& profiler, ProfilePhase phase)
+    : profiler(profiler), phase(phase), start(std::chrono::steady_clock::now())
+{
+}
+
+ScopedPhaseTimer::~ScopedPhaseTimer()
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    profiler.record(phase, static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Hot-path instrumentation for the simulation loop. Build with
+// FTS_PROFILING=0 to compile every FTS_PROFILE_PHASE scope out entirely.
+#ifndef FTS_PROFILING
+#define FTS_PROFILING 1
+#endif
+
+enum class ProfilePhase
+{
+    WaitUpdate,
+    PriorityUpdate,
+    DirectoryUpdate,
+    AssignFiles,
+    Aggregation,
+    SnapshotPublish,
+    Count
+};
+
+const char* profilePhaseName(ProfilePhase phase);
+
+struct PhaseStats
+{
+    std::uint64_t totalSamples;
+    int windowSamples;
+    double meanNs;
+    double p50Ns;
+    double p99Ns;
+    double maxNs;
+};
+
+// Histogram over the most recent WindowSize samples. Buckets are log-linear:
+// four sub-buckets per power of two, so percentiles are within ~19%.
+class PhaseHistogram
+{
+public:
+    static constexpr int WindowSize = 1024;
+    static constexpr int SubBuckets = 4;
+    static constexpr int BucketCount = 64 * SubBuckets;
+
+    PhaseHistogram();
+
+    void record(std::uint64_t nanoseconds);
+    void reset();
+    PhaseStats getStats() const;
+
+private:
+    static int bucketFor(std::uint64_t nanoseconds);
+    static double bucketUpperBound(int bucket);
+    double percentile(double fraction) const;
+
+    std::array<std::uint64_t, WindowSize> samples;
+    std::array<std::uint32_t, BucketCount> buckets;
+    int nextSample;
+    int windowSamples;
+    std::uint64_t windowSum;
+    std::uint64_t totalSamples;
+};
+
+class Profiler
+{
+public:
+    void record(ProfilePhase phase, std::uint64_t nanoseconds);
+    void reset();
+    std::vector<PhaseStats> getStats() const;
+
+private:
+    std::array<PhaseHistogram, static_cast<int>(ProfilePhase::Count)> histograms;
+};
+
+class ScopedPhaseTimer
+{
+public:
+    ScopedPhaseTimer(Profiler& profiler, ProfilePhase phase);
+    ~ScopedPhaseTimer();
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    Profiler& profiler;
+    ProfilePhase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define FTS_PROFILE_CONCAT_INNER(a, b) a##b
+#define FTS_PROFILE_CONCAT(a, b) FTS_PROFILE_CONCAT_INNER(a, b)
+
+#if FTS_PROFILING
+#define FTS_PROFILE_PHASE(profiler, phase) \
+    ScopedPhaseTimer FTS_PROFILE_CONCAT(phaseTimer, __LINE__){profiler, phase}
+#else
+#define FTS_PROFILE_PHASE(profiler, phase) ((void)0)
+#endif
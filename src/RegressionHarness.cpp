@@ -0,0 +1,498 @@
+#include "RegressionHarness.hpp"
+#include "ShardedSimulation.hpp"
+#include "TraceReplaySource.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr std::uint64_t FnvOffset = 14695981039346656037ull;
+    constexpr std::uint64_t FnvPrime = 1099511628211ull;
+
+    // Differences below this are timer noise rather than regressions
+    constexpr double WallTimeSlack = 0.005;
+
+    // Shards sum their partial wait totals in a different order
+    constexpr double TotalWaitTolerance = 1e-9;
+
+    void hashBytes(std::uint64_t& digest, const void* data, std::size_t size)
+    {
+        auto bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            digest = (digest ^ bytes[i]) * FnvPrime;
+        }
+    }
+
+    void hashResult(std::uint64_t& digest, const FileResult& result)
+    {
+        hashBytes(digest, &result.completionTime, sizeof(result.completionTime));
+        hashBytes(digest, &result.directoryId, sizeof(result.directoryId));
+        hashBytes(digest, &result.customerId, sizeof(result.customerId));
+        hashBytes(digest, &result.fileId, sizeof(result.fileId));
+        hashBytes(digest, &result.size, sizeof(result.size));
+        hashBytes(digest, &result.waitTime, sizeof(result.waitTime));
+        hashBytes(digest, &result.enqueueTime, sizeof(result.enqueueTime));
+        hashBytes(digest, &result.exitTime, sizeof(result.exitTime));
+    }
+
+    std::uint64_t hashSchedule(std::vector<ShardedSimulation::FinishedFile> files)
+    {
+        std::sort(files.begin(), files.end(), [](const auto& a, const auto& b)
+            {
+                return a.customerId != b.customerId ? a.customerId < b.customerId : a.fileId < b.fileId;
+            });
+
+        auto digest = FnvOffset;
+        for (const auto& file : files)
+        {
+            hashBytes(digest, &file.customerId, sizeof(file.customerId));
+            hashBytes(digest, &file.fileId, sizeof(file.fileId));
+            hashBytes(digest, &file.waitTime, sizeof(file.waitTime));
+        }
+        return digest;
+    }
+}
+
+RegressionHarness::RegressionHarness(const Config& config)
+    : config(config)
+{
+    this->config.repetitions = std::max(1, config.repetitions);
+    if (this->config.threadCounts.empty())
+    {
+        this->config.threadCounts = {1};
+    }
+}
+
+bool RegressionHarness::run()
+{
+    outcomes.clear();
+
+    auto traceError = std::string{};
+    bool traceWritten = writeReplayTrace(traceError);
+
+    bool passed = true;
+    std::size_t referenceIndex = 0;
+    for (const auto& engine : engines())
+    {
+        auto outcome = Outcome{};
+        outcome.name = engine.name;
+        outcome.digest = 0;
+        outcome.scheduleDigest = 0;
+        outcome.fileCount = 0;
+        outcome.elapsedTime = 0.0;
+        outcome.totalWaitTime = 0.0;
+        outcome.wallTime = 0.0;
+        outcome.peakRssKb = 0;
+        outcome.matchesReference = true;
+        outcome.withinBaseline = true;
+
+        if (engine.trace && !traceWritten)
+        {
+            outcome.failure = "no trace: " + traceError;
+            outcome.matchesReference = false;
+            if (engine.threadCount == config.threadCounts.front())
+            {
+                referenceIndex = outcomes.size();
+            }
+            outcomes.push_back(outcome);
+            passed = false;
+            continue;
+        }
+
+        // Fastest repetition for time, largest for memory
+        for (int i = 0; i < config.repetitions; i++)
+        {
+            auto result = ChildResult{};
+            long peakRssKb = 0;
+            if (!runInChild(engine, result, peakRssKb))
+            {
+                outcome.failure = "child process failed";
+                outcome.matchesReference = false;
+                break;
+            }
+
+            if (i == 0 || result.wallTime < outcome.wallTime)
+            {
+                outcome.wallTime = result.wallTime;
+            }
+            outcome.peakRssKb = std::max(outcome.peakRssKb, peakRssKb);
+            if (i > 0 && result.digest != outcome.digest)
+            {
+                outcome.failure = "not reproducible between repetitions";
+                outcome.matchesReference = false;
+            }
+            outcome.digest = result.digest;
+            outcome.scheduleDigest = result.scheduleDigest;
+            outcome.fileCount = result.fileCount;
+            outcome.elapsedTime = result.elapsedTime;
+            outcome.totalWaitTime = result.totalWaitTime;
+        }
+
+        // The first thread count of each workload and policy is its reference
+        if (engine.shardCount > 0)
+        {
+            compareWithUnsharded(outcome);
+        } else if (engine.threadCount == config.threadCounts.front())
+        {
+            referenceIndex = outcomes.size();
+        } else {
+            const auto& reference = outcomes[referenceIndex];
+            if (outcome.matchesReference &&
+                (outcome.digest != reference.digest || outcome.fileCount != reference.fileCount))
+            {
+                outcome.failure = "diverges from " + reference.name;
+                outcome.matchesReference = false;
+            }
+        }
+        outcomes.push_back(outcome);
+        passed = passed && outcomes.back().matchesReference;
+    }
+
+    if (traceWritten)
+    {
+        std::remove(tracePath.c_str());
+    }
+
+    if (config.baselinePath.empty())
+    {
+        return passed;
+    }
+
+    if (config.updateBaseline)
+    {
+        return saveBaseline() && passed;
+    }
+
+    auto baseline = std::vector<Outcome>{};
+    if (!loadBaseline(baseline))
+    {
+        return false;
+    }
+
+    for (auto& outcome : outcomes)
+    {
+        auto stored = std::find_if(baseline.begin(), baseline.end(),
+            [&outcome](const Outcome& candidate) { return candidate.name == outcome.name; });
+        if (!outcome.failure.empty())
+        {
+            continue;
+        }
+
+        if (stored == baseline.end())
+        {
+            outcome.failure = "no baseline entry";
+        } else if (stored->digest != outcome.digest)
+        {
+            outcome.failure = "results differ from baseline";
+        } else if (outcome.wallTime > stored->wallTime * (1.0 + config.threshold) + WallTimeSlack)
+        {
+            outcome.failure = "wall time regressed";
+        } else if (outcome.peakRssKb > stored->peakRssKb * (1.0 + config.threshold))
+        {
+            outcome.failure = "peak RSS regressed";
+        }
+        outcome.withinBaseline = outcome.failure.empty();
+        passed = passed && outcome.withinBaseline;
+    }
+    return passed;
+}
+
+const std::vector<RegressionHarness::Outcome>& RegressionHarness::getOutcomes() const
+{
+    return outcomes;
+}
+
+std::vector<RegressionHarness::Engine> RegressionHarness::engines() const
+{
+    struct Workload
+    {
+        const char* name;
+        bool sessions;
+        bool bandwidth;
+        bool pipeline;
+        bool dedup;
+        bool trace;
+    };
+
+    const Workload workloads[] = {
+        {"generated", false, false, false, false, false},
+        {"sessions", true, false, false, false, false},
+        {"bandwidth", false, true, false, false, false},
+        {"pipeline", false, false, true, false, false},
+        {"dedup", false, false, false, true, false},
+        {"trace", false, false, false, false, true}
+    };
+
+    auto list = std::vector<Engine>{};
+    for (const auto& workload : workloads)
+    {
+        for (auto policy : {SchedulingMode::CentralGreedy, SchedulingMode::WorkStealing})
+        {
+            for (int threadCount : config.threadCounts)
+            {
+                auto name = std::string(policy == SchedulingMode::WorkStealing ? "stealing/" : "central/")
+                    + workload.name + "/t" + std::to_string(threadCount);
+                list.push_back(Engine{name, policy, workload.sessions, workload.bandwidth, workload.pipeline,
+                                      workload.dedup, workload.trace, threadCount, 0});
+            }
+        }
+    }
+
+    // Sharding only runs central-greedy on the generated workload
+    for (int shardCount : config.shardCounts)
+    {
+        list.push_back(Engine{"sharded/generated/s" + std::to_string(shardCount), SchedulingMode::CentralGreedy,
+                              false, false, false, false, false, config.threadCounts.front(), shardCount});
+    }
+    return list;
+}
+
+void RegressionHarness::compareWithUnsharded(Outcome& outcome) const
+{
+    if (!outcome.matchesReference)
+    {
+        return;
+    }
+
+    auto referenceName = "central/generated/t" + std::to_string(config.threadCounts.front());
+    auto reference = std::find_if(outcomes.begin(), outcomes.end(),
+        [&referenceName](const Outcome& candidate) { return candidate.name == referenceName; });
+    if (reference == outcomes.end() || !reference->failure.empty())
+    {
+        outcome.failure = "no " + referenceName + " to compare with";
+        outcome.matchesReference = false;
+        return;
+    }
+
+    double waitSlack = TotalWaitTolerance * std::max(1.0, std::abs(reference->totalWaitTime));
+    if (outcome.scheduleDigest != reference->scheduleDigest || outcome.fileCount != reference->fileCount
+        || outcome.elapsedTime != reference->elapsedTime
+        || std::abs(outcome.totalWaitTime - reference->totalWaitTime) > waitSlack)
+    {
+        outcome.failure = "diverges from " + referenceName;
+        outcome.matchesReference = false;
+    }
+}
+
+bool RegressionHarness::runInChild(const Engine& engine, ChildResult& result, long& peakRssKb) const
+{
+    // A child per run gives each configuration its own peak RSS
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+        auto childResult = runEngine(engine);
+        bool written = write(fds[1], &childResult, sizeof(childResult)) == sizeof(childResult);
+        close(fds[1]);
+        _exit(written ? 0 : 1);
+    }
+
+    close(fds[1]);
+    bool received = read(fds[0], &result, sizeof(result)) == sizeof(result);
+    close(fds[0]);
+
+    int status = 0;
+    auto usage = rusage{};
+    if (wait4(pid, &status, 0, &usage) != pid)
+    {
+        return false;
+    }
+    peakRssKb = usage.ru_maxrss;
+    return received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+RegressionHarness::ChildResult RegressionHarness::runEngine(const Engine& engine) const
+{
+    if (engine.shardCount > 0)
+    {
+        return runShardedEngine(engine);
+    }
+
+    auto simulation = Simulation{config.directoryCount};
+    simulation.setSeed(config.seed);
+    simulation.setSchedulingMode(engine.policy);
+    simulation.setThreadCount(engine.threadCount);
+    auto workload = config.workload;
+    if (engine.dedup)
+    {
+        // Repeats give the cache something to hit
+        workload.repeatProbability = 0.3;
+        auto dedup = DedupConfig{};
+        dedup.enabled = true;
+        dedup.capacity = 50.0 * workload.maxFileSize;
+        simulation.setDedupConfig(dedup);
+    }
+    simulation.setWorkloadSpec(workload);
+    if (engine.sessions)
+    {
+        simulation.setCustomerBehavior(runSessions);
+    }
+    if (engine.bandwidth)
+    {
+        auto bandwidth = BandwidthConfig{};
+        bandwidth.enabled = true;
+        bandwidth.poolCount = 2;
+        bandwidth.poolBandwidth = 4.0 * config.directoryCount;
+        bandwidth.perDirectoryCap = 10.0;
+        simulation.setBandwidthConfig(bandwidth);
+    }
+    if (engine.pipeline)
+    {
+        // A deterministic stage and a seeded exponential one with a small
+        // buffer, so backpressure reaches the directories
+        auto pipeline = PipelineConfig{};
+        pipeline.stages.push_back(StageSpec{"verify", 2, StagePolicy::Fifo, ServiceModel::Deterministic, 0.1, 40.0, 16});
+        pipeline.stages.push_back(StageSpec{"upload", 1, StagePolicy::SmallestFirst, ServiceModel::Exponential, 0.2, 30.0, 4});
+        simulation.setPipeline(pipeline);
+    }
+    if (engine.trace)
+    {
+        auto error = std::string{};
+        if (!simulation.setTraceReplay(tracePath, error))
+        {
+            _exit(1);
+        }
+    }
+
+    auto result = ChildResult{FnvOffset, 0, 0, 0.0, 0.0, 0.0};
+    auto finished = std::vector<ShardedSimulation::FinishedFile>{};
+    simulation.setCompletionObserver([&result, &finished](const FileResult& file)
+        {
+            hashResult(result.digest, file);
+            finished.push_back(ShardedSimulation::FinishedFile{file.customerId, file.fileId, file.waitTime});
+            result.fileCount++;
+        });
+    simulation.initialize(config.customerCount);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    while (!simulation.allFilesProcessed())
+    {
+        simulation.step();
+    }
+    result.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    result.scheduleDigest = hashSchedule(finished);
+    result.elapsedTime = simulation.getElapsedTime();
+    result.totalWaitTime = simulation.getTotalWaitTime();
+    return result;
+}
+
+RegressionHarness::ChildResult RegressionHarness::runShardedEngine(const Engine& engine) const
+{
+    auto sharded = ShardedSimulation{engine.shardCount, config.directoryCount};
+    sharded.setSeed(config.seed);
+    sharded.setThreadCount(engine.threadCount);
+    sharded.setWorkloadSpec(config.workload);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    if (!sharded.run(config.customerCount))
+    {
+        _exit(1);
+    }
+
+    auto result = ChildResult{0, 0, 0, 0.0, 0.0, 0.0};
+    result.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    result.scheduleDigest = hashSchedule(sharded.getFinishedFiles());
+    // The completion order is not comparable, so the schedule is the digest
+    result.digest = result.scheduleDigest;
+    result.fileCount = static_cast<int>(sharded.getFinishedFiles().size());
+    result.elapsedTime = sharded.getElapsedTime();
+    result.totalWaitTime = sharded.getTotalWaitTime();
+    return result;
+}
+
+bool RegressionHarness::writeReplayTrace(std::string& error)
+{
+    auto stem = config.scratchDirectory + "/fts-regress-" + std::to_string(getpid());
+    auto csvPath = stem + ".csv";
+    tracePath = stem + ".trace";
+
+    auto csv = std::ofstream{csvPath};
+    if (!csv)
+    {
+        error = "cannot create " + csvPath;
+        return false;
+    }
+
+    // Epoch-second timestamps, so replay has to rebase them
+    auto gen = std::mt19937{config.seed};
+    auto gapDist = std::uniform_real_distribution<>{0.0, 1.0};
+    auto customerDist = std::uniform_int_distribution<>{1, config.customerCount};
+    auto sizeDist = std::uniform_int_distribution<>{config.workload.minFileSize, config.workload.maxFileSize};
+    int recordCount = config.customerCount * (config.workload.minFilesPerCustomer + config.workload.maxFilesPerCustomer) / 2;
+    double timestamp = 1.7e9;
+
+    csv << "timestamp,customer,size\n" << std::fixed << std::setprecision(3);
+    for (int i = 0; i < recordCount; i++)
+    {
+        timestamp += gapDist(gen);
+        int customer = customerDist(gen);
+        csv << timestamp << "," << customer << "," << sizeDist(gen) << "\n";
+    }
+    csv.close();
+
+    bool converted = csv && convertCsvTrace(csvPath, tracePath, error);
+    std::remove(csvPath.c_str());
+    return converted;
+}
+
+bool RegressionHarness::loadBaseline(std::vector<Outcome>& baseline) const
+{
+    auto in = std::ifstream{config.baselinePath};
+    if (!in)
+    {
+        return false;
+    }
+
+    auto line = std::string{};
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        auto fields = std::istringstream{line};
+        auto outcome = Outcome{};
+        if (fields >> outcome.name >> std::hex >> outcome.digest >> std::dec
+                   >> outcome.fileCount >> outcome.wallTime >> outcome.peakRssKb)
+        {
+            baseline.push_back(outcome);
+        }
+    }
+    return true;
+}
+
+bool RegressionHarness::saveBaseline() const
+{
+    auto out = std::ofstream{config.baselinePath};
+    out << "# name digest files wall_secs peak_rss_kb\n";
+    for (const auto& outcome : outcomes)
+    {
+        out << outcome.name << " " << std::hex << outcome.digest << std::dec << " "
+            << outcome.fileCount << " " << outcome.wallTime << " " << outcome.peakRssKb << "\n";
+    }
+    return static_cast<bool>(out);
+}
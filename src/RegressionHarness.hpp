@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "WorkloadSpec.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Differential check of every engine configuration against its reference.
+// Each seeded workload runs single-threaded first; every other thread count
+// must reproduce the same per-file completion log (directory, customer,
+// file and wait time, in order) bit for bit. Every configuration also runs
+// in a forked child so its wall time and peak RSS can be compared against a
+// stored baseline, which must have an entry for every configuration.
+// Trace replay uses a trace generated from the seed in the scratch
+// directory. Sharded runs report files per shard rather than in completion
+// order, so they are checked against the single-threaded central-greedy run
+// by every file's wait, the file count, makespan and total wait.
+class RegressionHarness
+{
+public:
+    struct Config
+    {
+        WorkloadSpec workload;
+        int customerCount = 500;
+        int directoryCount = 8;
+        unsigned int seed = 1;
+        std::vector<int> threadCounts = {1, 2, 4};
+        std::vector<int> shardCounts = {2, 4};
+        int repetitions = 3;
+        double threshold = 0.25;
+        std::string baselinePath;
+        bool updateBaseline = false;
+        std::string scratchDirectory = "/tmp";
+    };
+
+    struct Outcome
+    {
+        std::string name;
+        std::uint64_t digest;
+        // Every file's wait, by customer and file id; independent of the
+        // order files were reported in
+        std::uint64_t scheduleDigest;
+        int fileCount;
+        double elapsedTime;
+        double totalWaitTime;
+        double wallTime;
+        long peakRssKb;
+        bool matchesReference;
+        bool withinBaseline;
+        std::string failure;
+    };
+
+    RegressionHarness(const Config& config);
+
+    // Returns false when any configuration diverges or regresses
+    bool run();
+    const std::vector<Outcome>& getOutcomes() const;
+
+private:
+    struct Engine
+    {
+        std::string name;
+        SchedulingMode policy;
+        bool sessions;
+        bool bandwidth;
+        bool pipeline;
+        bool dedup;
+        bool trace;
+        int threadCount;
+        // Zero runs in a single process
+        int shardCount;
+    };
+
+    struct ChildResult
+    {
+        std::uint64_t digest;
+        std::uint64_t scheduleDigest;
+        int fileCount;
+        double elapsedTime;
+        double totalWaitTime;
+        double wallTime;
+    };
+
+    std::vector<Engine> engines() const;
+    bool runInChild(const Engine& engine, ChildResult& result, long& peakRssKb) const;
+    ChildResult runEngine(const Engine& engine) const;
+    ChildResult runShardedEngine(const Engine& engine) const;
+    void compareWithUnsharded(Outcome& outcome) const;
+    bool writeReplayTrace(std::string& error);
+    bool loadBaseline(std::vector<Outcome>& baseline) const;
+    bool saveBaseline() const;
+
+    Config config;
+    std::vector<Outcome> outcomes;
+    std::string tracePath;
+};
@@ -0,0 +1,311 @@
+#include "ResultWriter.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <unistd.h>
+
+namespace
+{
+    enum ColumnType : std::uint32_t
+    {
+        Int32 = 1,
+        Float64 = 2
+    };
+
+    struct ColumnSpec
+    {
+        const char* name;
+        ColumnType type;
+        std::uint32_t width;
+    };
+
+    constexpr ColumnSpec Columns[] = {
+        {"customer_id", Int32, 4},
+        {"file_id", Int32, 4},
+        {"size", Int32, 4},
+        {"directory_id", Int32, 4},
+        {"enqueue_time", Float64, 8},
+        {"start_time", Float64, 8},
+        {"transfer_end_time", Float64, 8},
+        {"finish_time", Float64, 8},
+        {"dispatch_priority", Float64, 8}
+    };
+
+    constexpr std::uint32_t ColumnCount = sizeof(Columns) / sizeof(Columns[0]);
+
+    constexpr std::uint64_t rowBytes()
+    {
+        std::uint64_t bytes = 0;
+        for (const auto& column : Columns) {
+            bytes += column.width;
+        }
+        return bytes;
+    }
+
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t columnCount;
+        std::uint64_t rowCount;
+        std::uint64_t rowsPerGroup;
+        std::uint64_t groupBytes;
+    };
+
+    struct ColumnDescriptor
+    {
+        char name[24];
+        std::uint32_t type;
+        std::uint32_t width;
+    };
+
+    static_assert(sizeof(FileHeader) + ColumnCount * sizeof(ColumnDescriptor) <= ResultWriter::HeaderBytes);
+
+    template <typename T>
+    void fillColumn(unsigned char* out, const FileResult* rows, std::uint64_t count, T (*field)(const FileResult&))
+    {
+        for (std::uint64_t i = 0; i < count; i++) {
+            auto value = field(rows[i]);
+            std::memcpy(out + i * sizeof(T), &value, sizeof(T));
+        }
+    }
+
+    bool writeFully(int fd, const unsigned char* data, std::size_t size)
+    {
+        while (size > 0) {
+            auto written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    void* allocateRing(std::size_t capacity)
+    {
+        return ::operator new(SpscRing<void*>::requiredBytes(capacity), std::align_val_t{64});
+    }
+
+    void freeRing(void* memory)
+    {
+        ::operator delete(memory, std::align_val_t{64});
+    }
+}
+
+ResultWriter::ResultWriter()
+    : fd(-1), filledMemory(nullptr), freeMemory(nullptr), filled(nullptr), recycled(nullptr),
+      current(nullptr), publishedChunks(0), closing(false), failed(false), writtenRows(0), droppedRows(0)
+{
+}
+
+ResultWriter::~ResultWriter()
+{
+    auto error = std::string{};
+    close(error);
+}
+
+bool ResultWriter::open(const std::string& path, std::string& error)
+{
+    if (isOpen()) {
+        error = "a result file is already open";
+        return false;
+    }
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error = "cannot create " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    writtenRows = 0;
+    droppedRows = 0;
+    publishedChunks = 0;
+    closing = false;
+    failed = false;
+    if (!writeHeader(0) || ::lseek(fd, HeaderBytes, SEEK_SET) < 0) {
+        error = "cannot write header to " + path;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    filledMemory = allocateRing(PoolChunks);
+    freeMemory = allocateRing(PoolChunks);
+    filled = new SpscRing<Chunk*>(filledMemory, PoolChunks, true);
+    recycled = new SpscRing<Chunk*>(freeMemory, PoolChunks, true);
+    groupBuffer.assign(RowsPerGroup * rowBytes(), 0);
+    for (std::size_t i = 0; i < PoolChunks; i++) {
+        chunks.push_back(std::make_unique<Chunk>());
+        recycled->tryPush(chunks.back().get());
+    }
+    current = acquireChunk();
+
+    writerThread = std::thread(&ResultWriter::writerLoop, this);
+    return true;
+}
+
+bool ResultWriter::close(std::string& error)
+{
+    if (!isOpen()) {
+        return true;
+    }
+
+    if (current && current->count > 0) {
+        filled->tryPush(current);
+        publishedChunks.fetch_add(1, std::memory_order_release);
+    }
+    current = nullptr;
+
+    closing.store(true, std::memory_order_release);
+    publishedChunks.fetch_add(1, std::memory_order_release);
+    publishedChunks.notify_one();
+    writerThread.join();
+
+    bool ok = !failed && writeHeader(writtenRows);
+    if (::close(fd) != 0) ok = false;
+    fd = -1;
+
+    delete filled;
+    delete recycled;
+    filled = nullptr;
+    recycled = nullptr;
+    freeRing(filledMemory);
+    freeRing(freeMemory);
+    filledMemory = nullptr;
+    freeMemory = nullptr;
+    chunks.clear();
+    groupBuffer.clear();
+    groupBuffer.shrink_to_fit();
+
+    if (!ok) {
+        error = "failed writing result file";
+    }
+    return ok;
+}
+
+bool ResultWriter::isOpen() const
+{
+    return fd >= 0;
+}
+
+void ResultWriter::record(const FileResult& result)
+{
+    if (!isOpen()) {
+        return;
+    }
+    if (!current) {
+        current = acquireChunk();
+        if (!current) {
+            droppedRows++;
+            return;
+        }
+    }
+
+    current->rows[current->count++] = result;
+    if (current->count == RowsPerGroup) {
+        publish(current);
+    }
+}
+
+std::uint64_t ResultWriter::getRowCount() const
+{
+    return writtenRows.load(std::memory_order_acquire);
+}
+
+std::uint64_t ResultWriter::getDroppedCount() const
+{
+    return droppedRows;
+}
+
+void ResultWriter::writerLoop()
+{
+    while (true) {
+        auto seen = publishedChunks.load(std::memory_order_acquire);
+
+        Chunk* chunk = nullptr;
+        while (filled->tryPop(chunk)) {
+            if (!failed && !writeGroup(*chunk)) {
+                failed = true;
+            }
+            if (!failed) {
+                writtenRows.fetch_add(chunk->count, std::memory_order_release);
+            }
+            // Holds the whole pool, so this cannot fill
+            recycled->tryPush(chunk);
+        }
+
+        if (closing.load(std::memory_order_acquire) && filled->isEmpty()) {
+            return;
+        }
+        publishedChunks.wait(seen, std::memory_order_acquire);
+    }
+}
+
+bool ResultWriter::writeGroup(const Chunk& chunk)
+{
+    // Padding rows past chunk.count are zero
+    std::memset(groupBuffer.data(), 0, groupBuffer.size());
+
+    auto out = groupBuffer.data();
+    fillColumn<std::int32_t>(out, chunk.rows, chunk.count, [](const FileResult& r) { return std::int32_t(r.customerId); });
+    out += RowsPerGroup * 4;
+    fillColumn<std::int32_t>(out, chunk.rows, chunk.count, [](const FileResult& r) { return std::int32_t(r.fileId); });
+    out += RowsPerGroup * 4;
+    fillColumn<std::int32_t>(out, chunk.rows, chunk.count, [](const FileResult& r) { return std::int32_t(r.size); });
+    out += RowsPerGroup * 4;
+    fillColumn<std::int32_t>(out, chunk.rows, chunk.count, [](const FileResult& r) { return std::int32_t(r.directoryId); });
+    out += RowsPerGroup * 4;
+    fillColumn<double>(out, chunk.rows, chunk.count, [](const FileResult& r) { return r.enqueueTime; });
+    out += RowsPerGroup * 8;
+    fillColumn<double>(out, chunk.rows, chunk.count, [](const FileResult& r) { return r.startTime; });
+    out += RowsPerGroup * 8;
+    fillColumn<double>(out, chunk.rows, chunk.count, [](const FileResult& r) { return r.completionTime; });
+    out += RowsPerGroup * 8;
+    fillColumn<double>(out, chunk.rows, chunk.count, [](const FileResult& r) { return r.exitTime; });
+    out += RowsPerGroup * 8;
+    fillColumn<double>(out, chunk.rows, chunk.count, [](const FileResult& r) { return r.dispatchPriority; });
+
+    return writeFully(fd, groupBuffer.data(), groupBuffer.size());
+}
+
+bool ResultWriter::writeHeader(std::uint64_t rowCount)
+{
+    unsigned char buffer[HeaderBytes] = {};
+
+    auto header = FileHeader{{'F', 'T', 'S', 'R', 'O', 'W', 'S', '1'}, 2, ColumnCount,
+                             rowCount, RowsPerGroup, RowsPerGroup * rowBytes()};
+    std::memcpy(buffer, &header, sizeof(header));
+
+    for (std::uint32_t i = 0; i < ColumnCount; i++) {
+        auto descriptor = ColumnDescriptor{};
+        std::strncpy(descriptor.name, Columns[i].name, sizeof(descriptor.name) - 1);
+        descriptor.type = Columns[i].type;
+        descriptor.width = Columns[i].width;
+        std::memcpy(buffer + sizeof(header) + i * sizeof(descriptor), &descriptor, sizeof(descriptor));
+    }
+
+    return ::pwrite(fd, buffer, sizeof(buffer), 0) == static_cast<ssize_t>(sizeof(buffer));
+}
+
+ResultWriter::Chunk* ResultWriter::acquireChunk()
+{
+    Chunk* chunk = nullptr;
+    if (!recycled->tryPop(chunk)) {
+        return nullptr;
+    }
+    chunk->count = 0;
+    return chunk;
+}
+
+void ResultWriter::publish(Chunk* chunk)
+{
+    // Holds the whole pool, so this cannot fail
+    filled->tryPush(chunk);
+    publishedChunks.fetch_add(1, std::memory_order_release);
+    publishedChunks.notify_one();
+    current = acquireChunk();
+}
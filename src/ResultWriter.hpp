@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "SpscRing.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streams per-file results to a columnar file from a background thread.
+//
+// The simulation thread fills fixed-size chunks and hands full ones over an
+// SPSC ring; the writer hands emptied chunks back over a second ring. All
+// chunks are allocated in open(). The producer side never waits or
+// allocates: if the writer falls the whole pool behind, records are counted
+// as dropped until it returns a chunk.
+//
+// File layout: a 4096-byte header, then row groups of RowsPerGroup rows.
+// Inside a group each column is stored contiguously at a fixed width, and
+// every group is the same size, so any value can be located by arithmetic
+// and the file can be mapped and scanned directly. The header's row count
+// excludes the padding in the last group.
+class ResultWriter
+{
+public:
+    static constexpr std::uint64_t RowsPerGroup = 4096;
+    static constexpr std::size_t HeaderBytes = 4096;
+
+    ResultWriter();
+    ~ResultWriter();
+
+    bool open(const std::string& path, std::string& error);
+    // Flushes the remaining rows, joins the writer thread and finalises the
+    // header. Call only once the producer has stopped recording.
+    bool close(std::string& error);
+    bool isOpen() const;
+
+    // Simulation thread only
+    void record(const FileResult& result);
+
+    std::uint64_t getRowCount() const;
+    std::uint64_t getDroppedCount() const;
+
+private:
+    // About 2 MB of rows; also the ring capacity, so pushes cannot fail
+    static constexpr std::size_t PoolChunks = 8;
+
+    struct Chunk
+    {
+        std::uint64_t count;
+        FileResult rows[RowsPerGroup];
+    };
+
+    void writerLoop();
+    bool writeGroup(const Chunk& chunk);
+    bool writeHeader(std::uint64_t rowCount);
+    Chunk* acquireChunk();
+    void publish(Chunk* chunk);
+
+    int fd;
+    void* filledMemory;
+    void* freeMemory;
+    SpscRing<Chunk*>* filled;
+    SpscRing<Chunk*>* recycled;
+    Chunk* current;
+    // The whole pool; owned here, borrowed by the rings
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::thread writerThread;
+    std::atomic<std::uint64_t> publishedChunks;
+    std::atomic<bool> closing;
+    std::atomic<bool> failed;
+    std::atomic<std::uint64_t> writtenRows;
+    std::uint64_t droppedRows;
+    std::vector<unsigned char> groupBuffer;
+};
@@ -0,0 +1,86 @@
+#include "ShardChannel.hpp"
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <new>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+    void cpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    std::uint32_t* futexWord(std::atomic<std::uint32_t>& word)
+    {
+        return reinterpret_cast<std::uint32_t*>(&word);
+    }
+}
+
+std::size_t ShardChannel::requiredBytes(std::size_t capacity)
+{
+    return sizeof(Bell) + SpscRing<ShardMessage>::requiredBytes(capacity);
+}
+
+ShardChannel::ShardChannel(void* memory, std::size_t capacity, bool initialize)
+    : bell(static_cast<Bell*>(memory)),
+      messages(static_cast<char*>(memory) + sizeof(Bell), capacity, initialize)
+{
+    if (initialize) {
+        bell = new (memory) Bell{};
+    }
+}
+
+bool ShardChannel::push(const ShardMessage& message, const std::function<bool()>& peerAlive)
+{
+    return waitUntil([&]() { return messages.tryPush(message); }, peerAlive);
+}
+
+bool ShardChannel::pop(ShardMessage& message, const std::function<bool()>& peerAlive)
+{
+    return waitUntil([&]() { return messages.tryPop(message); }, peerAlive);
+}
+
+template <typename Attempt>
+bool ShardChannel::waitUntil(const Attempt& attempt, const std::function<bool()>& peerAlive)
+{
+    // Producer and consumer share the bell: at most one of them can be
+    // waiting, on a full ring or an empty one, so one word serves both
+    while (true) {
+        for (int spin = 0; spin < SpinCount; spin++) {
+            if (attempt()) {
+                ring();
+                return true;
+            }
+            cpuRelax();
+        }
+
+        auto seen = bell->sequence.load();
+        bell->sleepers.fetch_add(1);
+        if (attempt()) {
+            bell->sleepers.fetch_sub(1);
+            ring();
+            return true;
+        }
+
+        auto timeout = timespec{0, SleepTimeoutNs};
+        syscall(SYS_futex, futexWord(bell->sequence), FUTEX_WAIT, seen, &timeout, nullptr, 0);
+        bell->sleepers.fetch_sub(1);
+
+        if (!peerAlive()) {
+            return false;
+        }
+    }
+}
+
+void ShardChannel::ring()
+{
+    bell->sequence.fetch_add(1);
+    if (bell->sleepers.load() > 0) {
+        syscall(SYS_futex, futexWord(bell->sequence), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
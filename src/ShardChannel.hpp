@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "SpscRing.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+enum class ShardMessageType
+{
+    // Coordinator to shard
+    BeginTick,
+    Select,
+    Take,
+    Dispatch,
+    EndTick,
+    Shutdown,
+    // Either direction: a directory finished a file
+    Completion,
+    // Shard to coordinator
+    TickStarted,
+    Offer,
+    OffersDone,
+    Waited,
+    TickReport
+};
+
+// Every message of the sharded protocol. count and limit carry the active
+// customer count, idle directories, offer limit or dispatched offers,
+// depending on the type. Waited carries one file its customer's shard saw
+// finish this tick, with its wait.
+struct ShardMessage
+{
+    ShardMessageType type = ShardMessageType::Shutdown;
+    long long tick = 0;
+    int count = 0;
+    int limit = 0;
+    ShardFile file = {};
+    double elapsedTime = 0.0;
+    double totalWaitTime = 0.0;
+    double waitTime = 0.0;
+    int processedFiles = 0;
+    bool completed = false;
+};
+
+// One direction of shard traffic: an SPSC ring plus a futex word, both in the
+// caller's shared mapping. A blocked side spins briefly, then sleeps on the
+// futex. The futex is process-shared, because a private one (as used by
+// std::atomic::wait) cannot wake another process. Sleeps time out now and
+// then, so a peer that died is noticed instead of waited on forever.
+class ShardChannel
+{
+public:
+    static std::size_t requiredBytes(std::size_t capacity);
+
+    ShardChannel(void* memory, std::size_t capacity, bool initialize);
+
+    // Both return false once peerAlive reports the other side gone
+    bool push(const ShardMessage& message, const std::function<bool()>& peerAlive);
+    bool pop(ShardMessage& message, const std::function<bool()>& peerAlive);
+
+private:
+    static constexpr int SpinCount = 256;
+    static constexpr long SleepTimeoutNs = 50'000'000;
+
+    struct alignas(64) Bell
+    {
+        std::atomic<std::uint32_t> sequence;
+        std::atomic<std::uint32_t> sleepers;
+    };
+
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free && sizeof(std::atomic<std::uint32_t>) == 4,
+                  "the futex word must be a plain 32-bit integer");
+
+    template <typename Attempt>
+    bool waitUntil(const Attempt& attempt, const std::function<bool()>& peerAlive);
+    void ring();
+
+    Bell* bell;
+    SpscRing<ShardMessage> messages;
+};
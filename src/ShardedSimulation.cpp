@@ -0,0 +1,497 @@
+#include "ShardedSimulation.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sys/wait.h>
+#include <unistd.h>
+
+ShardedSimulation::ShardedSimulation(int shardCount, int directoryCount)
+    : shardCount(std::max(1, shardCount)), directoryCount(std::max(1, directoryCount)),
+      threadCount(1), seed(0), tickCount(0), elapsedTime(0.0),
+      processedFilesCount(0), totalWaitTime(0.0), crossShardDispatchCount(0), completed(false)
+{
+}
+
+ShardedSimulation::~ShardedSimulation()
+{
+    shutdownShards();
+}
+
+void ShardedSimulation::setSeed(unsigned int seed)
+{
+    this->seed = seed;
+}
+
+void ShardedSimulation::setThreadCount(int threadCount)
+{
+    this->threadCount = threadCount;
+}
+
+void ShardedSimulation::setWorkloadSpec(const WorkloadSpec& spec)
+{
+    workload = spec;
+}
+
+bool ShardedSimulation::run(int customerCount)
+{
+    tickCount = 0;
+    elapsedTime = 0.0;
+    processedFilesCount = 0;
+    totalWaitTime = 0.0;
+    crossShardDispatchCount = 0;
+    completed = false;
+    finishedFiles.clear();
+
+    if (!launchShards(customerCount))
+    {
+        shutdownShards();
+        return false;
+    }
+
+    while (!completed)
+    {
+        tickCount++;
+        if (!runTick())
+        {
+            shutdownShards();
+            return false;
+        }
+    }
+
+    shutdownShards();
+    return true;
+}
+
+int ShardedSimulation::getShardCount() const
+{
+    return shardCount;
+}
+
+long long ShardedSimulation::getTickCount() const
+{
+    return tickCount;
+}
+
+double ShardedSimulation::getElapsedTime() const
+{
+    return elapsedTime;
+}
+
+int ShardedSimulation::getProcessedFilesCount() const
+{
+    return processedFilesCount;
+}
+
+double ShardedSimulation::getTotalWaitTime() const
+{
+    return totalWaitTime;
+}
+
+double ShardedSimulation::getWaitTimePercentile(double fraction) const
+{
+    if (finishedFiles.empty())
+    {
+        return 0.0;
+    }
+
+    auto sorted = std::vector<double>{};
+    for (const auto& file : finishedFiles)
+    {
+        sorted.push_back(file.waitTime);
+    }
+    auto rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+    auto index = std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+const std::vector<ShardedSimulation::FinishedFile>& ShardedSimulation::getFinishedFiles() const
+{
+    return finishedFiles;
+}
+
+long long ShardedSimulation::getCrossShardDispatchCount() const
+{
+    return crossShardDispatchCount;
+}
+
+bool ShardedSimulation::launchShards(int customerCount)
+{
+    // Every shard needs at least one customer and one directory
+    int count = std::min({shardCount, directoryCount, std::max(1, customerCount)});
+    int firstCustomer = 0;
+
+    auto channelBytes = (ShardChannel::requiredBytes(RingCapacity) + 63) / 64 * 64;
+
+    for (int i = 0; i < count; i++)
+    {
+        auto shard = Shard{};
+        shard.pid = -1;
+        shard.firstCustomer = firstCustomer;
+        shard.customerCount = customerCount / count + (i < customerCount % count ? 1 : 0);
+        shard.directoryCount = directoryCount / count + (i < directoryCount % count ? 1 : 0);
+        shard.idleDirectories = 0;
+        shard.taken = 0;
+        firstCustomer += shard.customerCount;
+
+        shard.region = std::make_unique<SharedMemoryRegion>(2 * channelBytes);
+        if (!shard.region->isValid())
+        {
+            return false;
+        }
+
+        auto base = static_cast<char*>(shard.region->getData());
+        shard.commands = std::make_unique<ShardChannel>(base, RingCapacity, true);
+        shard.reports = std::make_unique<ShardChannel>(base + channelBytes, RingCapacity, true);
+        shards.push_back(std::move(shard));
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            return false;
+        }
+        if (pid == 0)
+        {
+            runShard(i, customerCount);
+        }
+        shards[i].pid = pid;
+    }
+
+    return true;
+}
+
+void ShardedSimulation::runShard(int shardIndex, int customerCount)
+{
+    auto& shard = shards[shardIndex];
+    pid_t coordinator = getppid();
+    auto coordinatorAlive = [coordinator]() { return getppid() == coordinator; };
+
+    // Every shard generates the whole workload from the same seed and keeps
+    // its own slice of it
+    auto simulation = Simulation{shard.directoryCount};
+    simulation.setSeed(seed);
+    simulation.setThreadCount(threadCount);
+    simulation.setWorkloadSpec(workload);
+    simulation.initializeSlice(customerCount, shard.firstCustomer, shard.customerCount);
+
+    auto files = std::vector<ShardFile>{};
+    auto waited = std::vector<ShardMessage>{};
+    auto reply = [&](ShardMessage message)
+        {
+            if (!shard.reports->push(message, coordinatorAlive))
+            {
+                _exit(1);
+            }
+        };
+
+    while (true)
+    {
+        auto command = ShardMessage{};
+        if (!shard.commands->pop(command, coordinatorAlive))
+        {
+            _exit(1);
+        }
+
+        auto message = ShardMessage{};
+        message.tick = command.tick;
+        double waitTime = 0.0;
+        switch (command.type)
+        {
+        case ShardMessageType::BeginTick:
+            files.clear();
+            message.count = simulation.beginShardTick(files);
+            message.limit = simulation.getIdleDirectoryCount();
+            for (const auto& file: files)
+            {
+                auto completion = ShardMessage{};
+                completion.type = ShardMessageType::Completion;
+                completion.tick = command.tick;
+                completion.file = file;
+                reply(completion);
+            }
+            message.type = ShardMessageType::TickStarted;
+            reply(message);
+            break;
+
+        case ShardMessageType::Completion:
+            if (simulation.completeShardFile(command.file, waitTime))
+            {
+                message.type = ShardMessageType::Waited;
+                message.file = command.file;
+                message.waitTime = waitTime;
+                waited.push_back(message);
+            }
+            break;
+
+        case ShardMessageType::Select:
+            files.clear();
+            simulation.offerShardFiles(command.count, command.limit, files);
+            for (const auto& file: files)
+            {
+                auto offer = ShardMessage{};
+                offer.type = ShardMessageType::Offer;
+                offer.tick = command.tick;
+                offer.file = file;
+                reply(offer);
+            }
+            message.type = ShardMessageType::OffersDone;
+            reply(message);
+            break;
+
+        case ShardMessageType::Take:
+            simulation.takeShardFiles(command.count);
+            break;
+
+        case ShardMessageType::Dispatch:
+            simulation.assignShardFile(command.file);
+            break;
+
+        case ShardMessageType::EndTick:
+            simulation.finishShardTick();
+            for (const auto& file : waited)
+            {
+                reply(file);
+            }
+            waited.clear();
+            message.type = ShardMessageType::TickReport;
+            message.elapsedTime = simulation.getElapsedTime();
+            message.totalWaitTime = simulation.getTotalWaitTime();
+            message.processedFiles = simulation.getProcessedFilesCount();
+            message.completed = simulation.allFilesProcessed();
+            reply(message);
+            break;
+
+        case ShardMessageType::Shutdown:
+            _exit(0);
+
+        default:
+            _exit(1);
+        }
+    }
+}
+
+bool ShardedSimulation::runTick()
+{
+    // Round 1: advance every shard and collect completions. Each shard is
+    // drained up to its TickStarted before anything else is sent, so neither
+    // side can block on a full ring while the other does too.
+    auto completions = std::vector<ShardFile>{};
+    int activeCustomers = 0;
+    int idleDirectories = 0;
+    for (auto& shard : shards)
+    {
+        if (!send(shard, ShardMessage{ShardMessageType::BeginTick, tickCount}))
+        {
+            return false;
+        }
+    }
+    for (auto& shard : shards)
+    {
+        while (true)
+        {
+            auto message = ShardMessage{};
+            if (!receive(shard, message) || message.tick != tickCount)
+            {
+                return false;
+            }
+            if (message.type == ShardMessageType::Completion)
+            {
+                completions.push_back(message.file);
+            } else if (message.type == ShardMessageType::TickStarted) {
+                activeCustomers += message.count;
+                shard.idleDirectories = message.limit;
+                idleDirectories += message.limit;
+                break;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    // Round 2: completions go home to their customers, then every shard
+    // offers as many head files as could be dispatched this tick
+    for (const auto& file : completions)
+    {
+        auto message = ShardMessage{ShardMessageType::Completion, tickCount};
+        message.file = file;
+        if (!send(shards[shardOfCustomer(file.customerId)], message))
+        {
+            return false;
+        }
+    }
+    for (auto& shard : shards)
+    {
+        auto message = ShardMessage{ShardMessageType::Select, tickCount};
+        message.count = activeCustomers;
+        message.limit = idleDirectories;
+        if (!send(shard, message))
+        {
+            return false;
+        }
+    }
+    for (auto& shard : shards)
+    {
+        shard.offers.clear();
+        shard.taken = 0;
+        while (true)
+        {
+            auto message = ShardMessage{};
+            if (!receive(shard, message) || message.tick != tickCount)
+            {
+                return false;
+            }
+            if (message.type == ShardMessageType::Offer)
+            {
+                shard.offers.push_back(message.file);
+            } else if (message.type == ShardMessageType::OffersDone) {
+                break;
+            } else {
+                return false;
+            }
+        }
+    }
+
+    // Round 3: each shard's offers are in its local greedy order, and
+    // customer slices are contiguous, so merging the heads with ties going to
+    // the lower shard reproduces the unsharded dispatch order. Idle
+    // directories are filled in board order, which is shard order.
+    for (int target = 0; target < static_cast<int>(shards.size()); target++)
+    {
+        for (int k = 0; k < shards[target].idleDirectories; k++)
+        {
+            int source = -1;
+            double highestPriority = -1.0;
+            for (int s = 0; s < static_cast<int>(shards.size()); s++)
+            {
+                auto& shard = shards[s];
+                if (shard.taken < static_cast<int>(shard.offers.size())
+                    && shard.offers[shard.taken].priority > highestPriority)
+                {
+                    source = s;
+                    highestPriority = shard.offers[shard.taken].priority;
+                }
+            }
+            if (source < 0)
+            {
+                break;
+            }
+
+            auto message = ShardMessage{ShardMessageType::Dispatch, tickCount};
+            message.file = shards[source].offers[shards[source].taken++];
+            if (source != target)
+            {
+                crossShardDispatchCount++;
+            }
+            if (!send(shards[target], message))
+            {
+                return false;
+            }
+        }
+    }
+
+    // Round 4: return undispatched offers, then collect the waits of
+    // finished files and aggregate
+    for (auto& shard : shards)
+    {
+        auto take = ShardMessage{ShardMessageType::Take, tickCount};
+        take.count = shard.taken;
+        if (!send(shard, take) || !send(shard, ShardMessage{ShardMessageType::EndTick, tickCount}))
+        {
+            return false;
+        }
+    }
+
+    completed = true;
+    elapsedTime = 0.0;
+    processedFilesCount = 0;
+    totalWaitTime = 0.0;
+    for (auto& shard : shards)
+    {
+        auto report = ShardMessage{};
+        while (true)
+        {
+            if (!receive(shard, report) || report.tick != tickCount)
+            {
+                return false;
+            }
+            if (report.type == ShardMessageType::Waited)
+            {
+                finishedFiles.push_back(FinishedFile{report.file.customerId, report.file.fileId, report.waitTime});
+            } else if (report.type == ShardMessageType::TickReport) {
+                break;
+            } else {
+                return false;
+            }
+        }
+
+        elapsedTime = std::max(elapsedTime, report.elapsedTime);
+        processedFilesCount += report.processedFiles;
+        totalWaitTime += report.totalWaitTime;
+        completed = completed && report.completed;
+    }
+    return true;
+}
+
+int ShardedSimulation::shardOfCustomer(int customerId) const
+{
+    int index = customerId - 1;
+    for (int i = 0; i < static_cast<int>(shards.size()); i++)
+    {
+        if (index < shards[i].firstCustomer + shards[i].customerCount)
+        {
+            return i;
+        }
+    }
+    return static_cast<int>(shards.size()) - 1;
+}
+
+bool ShardedSimulation::send(Shard& shard, const ShardMessage& message)
+{
+    if (shard.pid <= 0)
+    {
+        return false;
+    }
+
+    auto shardAlive = [&shard]() { return waitpid(shard.pid, nullptr, WNOHANG) == 0; };
+    if (!shard.commands->push(message, shardAlive))
+    {
+        shard.pid = -1;
+        return false;
+    }
+    return true;
+}
+
+bool ShardedSimulation::receive(Shard& shard, ShardMessage& message)
+{
+    if (shard.pid <= 0)
+    {
+        return false;
+    }
+
+    auto shardAlive = [&shard]() { return waitpid(shard.pid, nullptr, WNOHANG) == 0; };
+    if (!shard.reports->pop(message, shardAlive))
+    {
+        shard.pid = -1;
+        return false;
+    }
+    return true;
+}
+
+void ShardedSimulation::shutdownShards()
+{
+    for (auto& shard : shards)
+    {
+        if (shard.pid > 0)
+        {
+            send(shard, ShardMessage{ShardMessageType::Shutdown, tickCount});
+            if (shard.pid > 0)
+            {
+                waitpid(shard.pid, nullptr, 0);
+            }
+        }
+    }
+    shards.clear();
+}
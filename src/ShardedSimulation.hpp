@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ShardChannel.hpp"
+#include "SharedMemoryRegion.hpp"
+#include "WorkloadSpec.hpp"
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+// Runs one Simulation shard per forked process. Customers and directories
+// are partitioned across shards in contiguous slices of one workload, and
+// every central-greedy dispatch goes through the coordinator, so a customer's
+// file can go to a directory in any shard.
+//
+// Each tick runs as four rounds, in conservative lockstep:
+//   1. BeginTick: shards advance wait times and directories, and report
+//      their completions, active customers and idle directories.
+//   2. Completions go back to the customers' shards, then Select: shards
+//      update priorities for the run-wide active count and offer head files
+//      in local greedy order.
+//   3. The coordinator merges the offers for the idle directories in board
+//      order, then sends Dispatch to directory shards and Take to customer
+//      shards.
+//   4. EndTick: shards aggregate and report, along with the wait of every
+//      file whose customer saw it finish this tick.
+// A shard handles its messages strictly in order, so it cannot begin tick
+// t + 1 before it has drained everything for tick t. The schedule is the one
+// an unsharded run of the same workload produces. All traffic is plain
+// structs over SPSC rings in shared memory, so it could later travel over a
+// network.
+class ShardedSimulation
+{
+public:
+    struct FinishedFile
+    {
+        int customerId;
+        int fileId;
+        double waitTime;
+    };
+
+    ShardedSimulation(int shardCount, int directoryCount);
+    ~ShardedSimulation();
+
+    void setSeed(unsigned int seed);
+    void setThreadCount(int threadCount);
+    void setWorkloadSpec(const WorkloadSpec& spec);
+
+    bool run(int customerCount);
+
+    int getShardCount() const;
+    long long getTickCount() const;
+    double getElapsedTime() const;
+    int getProcessedFilesCount() const;
+    double getTotalWaitTime() const;
+    double getWaitTimePercentile(double fraction) const;
+    // In the order the coordinator heard of them: by tick, then by shard
+    const std::vector<FinishedFile>& getFinishedFiles() const;
+    long long getCrossShardDispatchCount() const;
+
+private:
+    struct Shard
+    {
+        pid_t pid;
+        int firstCustomer;
+        int customerCount;
+        int directoryCount;
+        std::unique_ptr<SharedMemoryRegion> region;
+        std::unique_ptr<ShardChannel> commands;
+        std::unique_ptr<ShardChannel> reports;
+        std::vector<ShardFile> offers;
+        int idleDirectories;
+        int taken;
+    };
+
+    static constexpr std::size_t RingCapacity = 1024;
+
+    bool launchShards(int customerCount);
+    [[noreturn]] void runShard(int shardIndex, int customerCount);
+    bool runTick();
+    bool send(Shard& shard, const ShardMessage& message);
+    bool receive(Shard& shard, ShardMessage& message);
+    int shardOfCustomer(int customerId) const;
+    void shutdownShards();
+
+    std::vector<Shard> shards;
+    int shardCount;
+    int directoryCount;
+    int threadCount;
+    unsigned int seed;
+    WorkloadSpec workload;
+
+    long long tickCount;
+    double elapsedTime;
+    int processedFilesCount;
+    double totalWaitTime;
+    long long crossShardDispatchCount;
+    bool completed;
+    // Reported by each customer's shard
+    std::vector<FinishedFile> finishedFiles;
+};
@@ -0,0 +1,49 @@
+#include "SharedMemoryRegion.hpp"
+#include <atomic>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SharedMemoryRegion::SharedMemoryRegion(std::size_t size)
+    : data(nullptr), size(size)
+{
+    static std::atomic<int> regionCounter{0};
+    auto name = "/fts-" + std::to_string(getpid()) + "-" + std::to_string(regionCounter++);
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return;
+    }
+    shm_unlink(name.c_str());
+
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            data = mapped;
+        }
+    }
+    close(fd);
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    if (data) {
+        munmap(data, size);
+    }
+}
+
+bool SharedMemoryRegion::isValid() const
+{
+    return data != nullptr;
+}
+
+void* SharedMemoryRegion::getData() const
+{
+    return data;
+}
+
+std::size_t SharedMemoryRegion::getSize() const
+{
+    return size;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+// Anonymous POSIX shared memory mapping. The name is unlinked as soon as the
+// region is mapped, so it is shared only with processes forked afterwards
+// and disappears with the last of them.
+class SharedMemoryRegion
+{
+public:
+    SharedMemoryRegion(std::size_t size);
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    bool isValid() const;
+    void* getData() const;
+    std::size_t getSize() const;
+
+private:
+    void* data;
+    std::size_t size;
+};
@@ -1,13 +1,36 @@
 #include "Simulation.hpp"
+#include <algorithm>
 #include <chrono>
+#include <climits>
+#include <cmath>
 #include <mutex>
 #include <random>
 #include <thread>
+#include <utility>
+
+namespace
+{
+    double percentileOf(std::vector<double>& values, double fraction)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+
+        auto rank = static_cast<std::size_t>(std::ceil(fraction * values.size()));
+        auto index = std::min(values.size() - 1, rank > 0 ? rank - 1 : 0);
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+}
 
 Simulation::Simulation(int directoryCount) :
     running(false), paused(false), stopRequested(false),
     elapsedTime(0.0), processedFilesCount(0), totalWaitTime(0.0),
-    timeStep(0.1), simulationSpeed(1.0)
+    timeStep(0.1), simulationSpeed(1.0), achievedSpeed(0.0), overloaded(false), seed(0),
+    schedulingMode(SchedulingMode::CentralGreedy), stealCount(0), localDispatchCount(0),
+    publishCustomers(false), detailCustomer(-1), skippedTraceRecords(0), overviewSampleCount(-1), commandQueue(CommandQueueCapacity), commandSequence(0),
+    nextDirectoryId(directoryCount + 1)
 {
     for (int i = 0; i < directoryCount; i++)
     {
@@ -18,32 +41,66 @@ Simulation::Simulation(int directoryCount) :
 Simulation::~Simulation()
 {
     stop();
-    for (auto& customer : customers)
-    {
-        delete customer;
-    }
-
-    customers.clear();
+    clearCustomers();
 }
 
 void Simulation::initialize(int customerCount)
 {
-    for (auto& customer: customers)
-    {
-        delete customer;
-    }
-    customers.clear();
+    initializeSlice(customerCount, 0, customerCount);
+}
+
+void Simulation::initializeSlice(int customerCount, int firstKept, int keptCount)
+{
+    clearCustomers();
 
     for (auto& directory: directories)
     {
         directory.reset();
     }
+    // Offered and in-flight files are out of their customers' lists
+    for (auto& offered: shardOffered)
+    {
+        delete offered.file;
+    }
+    for (auto& entry: shardInFlight)
+    {
+        delete entry.second.file;
+    }
+    shardOffered.clear();
+    shardInFlight.clear();
+    shardTransfers.clear();
+    shardProxies.clear();
 
     elapsedTime = 0.0;
     processedFilesCount = 0;
     totalWaitTime = 0;
+    stealCount = 0;
+    localDispatchCount = 0;
+
+    scheduledCommands = {};
+    profiler.reset();
+    timeSeries.reset();
+    timeSeriesOverview.reset();
+    steadyState.reset(steadyStateConfig);
+    steadyStateWaits.clear();
+    overviewSampleCount = -1;
+    commandRandom.seed(seed != 0 ? seed : std::random_device{}());
+
+    rebuildBandwidthPools();
+    dedupCache = dedupConfig.enabled
+        ? std::make_unique<DedupCache>(dedupConfig.capacity, dedupConfig.lookupTime)
+        : nullptr;
+    for (auto& directory: directories)
+    {
+        directory.setDedupCache(dedupCache.get());
+    }
+    pipeline.configure(pipelineConfig, seed != 0 ? seed : std::random_device{}());
+    generateCustomers(customerCount, firstKept, keptCount);
 
-    generateCustomers(customerCount);
+    if (schedulingMode == SchedulingMode::WorkStealing)
+    {
+        partitionPendingFiles();
+    }
 }
 
 void Simulation::start()
@@ -60,18 +117,14 @@ void Simulation::start()
     simulationThread = std::thread(&Simulation::simulationLoop, this);
 }
 
-void Simulation::pause()
+bool Simulation::pause()
 {
-    paused = true;
+    return postCommand(SimulationCommand{CommandType::Pause});
 }
 
-void Simulation::resume()
+bool Simulation::resume()
 {
-    if (running && paused)
-    {
-        paused = false;
-        pauseCondition.notify_one();
-    }
+    return postCommand(SimulationCommand{CommandType::Resume});
 }
 
 void Simulation::stop()
@@ -79,30 +132,23 @@ void Simulation::stop()
     if (running)
     {
         stopRequested = true;
-        if (paused)
-        {
-            resume();
-        }
-
-        if (simulationThread.joinable())
-        {
-            simulationThread.join();
-        }
+    }
 
-        running = false;
-        paused = false;
+    // The loop may already have finished on its own after completing
+    if (simulationThread.joinable())
+    {
+        simulationThread.join();
     }
+
+    running = false;
+    paused = false;
 }
 
 void Simulation::reset()
 {
     stop();
 
-    for (auto& customer : customers)
-    {
-        delete customer;
-    }
-    customers.clear();
+    clearCustomers();
     
     for (auto& directory : directories)
     {
@@ -117,6 +163,19 @@ void Simulation::reset()
     elapsedTime = 0.0;
     processedFilesCount = 0;
     totalWaitTime = 0.0;
+    stealCount = 0;
+    localDispatchCount = 0;
+    achievedSpeed = 0.0;
+    overloaded = false;
+
+    // Drop commands that arrived after the previous run ended
+    auto stale = SimulationCommand{};
+    while (commandQueue.tryPop(stale))
+    {
+    }
+
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    snapshot.reset();
 }
 
 bool Simulation::isRunning() const
@@ -131,7 +190,7 @@ bool Simulation::isPaused() const
 
 bool Simulation::isCompleted() const
 {
-    return running && allFilesProcessed();
+    return running && (allFilesProcessed() || reachedSteadyState());
 }
 
 int Simulation::getCustomersCount() const
@@ -169,141 +228,1232 @@ double Simulation::getTotalWaitTime() const
     return totalWaitTime;
 }
 
-void Simulation::setSpeed(int speed)
+double Simulation::getWaitTimePercentile(double fraction) const
+{
+    auto waitTimes = std::vector<double>{};
+    for (auto& customer : customers)
+    {
+        for (int i = 0; i < customer->getProcessedFilesCount(); i++)
+        {
+            waitTimes.push_back(customer->getProcessedFile(i).getWaitTime());
+        }
+    }
+    return percentileOf(waitTimes, fraction);
+}
+
+double Simulation::getSteadyStateWaitPercentile(double fraction) const
 {
-    // Convert from 1-10 to 0.2-2.0
-    simulationSpeed = 0.2 + (speed - 1) * 0.2;
+    if (!steadyStateConfig.enabled)
+    {
+        return getWaitTimePercentile(fraction);
+    }
+
+    auto warmup = static_cast<std::size_t>(steadyState.getWarmupObservations());
+    auto waitTimes = std::vector<double>(steadyStateWaits.begin() + std::min(warmup, steadyStateWaits.size()),
+                                         steadyStateWaits.end());
+    return percentileOf(waitTimes, fraction);
 }
 
-void Simulation::simulationLoop()
+SchedulingMode Simulation::getSchedulingMode() const
 {
-    while (running && !stopRequested)
+    return schedulingMode;
+}
+
+int Simulation::getStealCount() const
+{
+    return stealCount;
+}
+
+int Simulation::getThreadCount() const
+{
+    return workerPool ? workerPool->getThreadCount() : 1;
+}
+
+int Simulation::getLocalDispatchCount() const
+{
+    return localDispatchCount;
+}
+
+double Simulation::getLocality() const
+{
+    int dispatched = localDispatchCount + stealCount;
+    if (dispatched == 0)
     {
-        if (paused)
-        {
-            std::unique_lock<std::mutex> lock(simulationMutex);
-            pauseCondition.wait(lock, [this]()
-                {
-                    return !paused || stopRequested;
-                });
-            
-            if (stopRequested) break;
-        }
+        return 1.0;
+    }
 
-        double deltaTime = timeStep * simulationSpeed;
-        elapsedTime += deltaTime;
+    return static_cast<double>(localDispatchCount) / dispatched;
+}
 
-        for (auto& customer: customers)
-        {
-            customer->updateWaitTimes(deltaTime);
-        }
+double Simulation::getRequestedSpeed() const
+{
+    return simulationSpeed;
+}
 
-        int activeCustomerCount = 0;
-        for (auto& customer: customers)
-        {
-            if (!customer->isCompleted()) {
-                activeCustomerCount++;
-            }
-        }
+double Simulation::getAchievedSpeed() const
+{
+    return achievedSpeed;
+}
 
-        for (auto& customer: customers)
-        {
-            customer->updatePriorities(activeCustomerCount);
-        }
+bool Simulation::isOverloaded() const
+{
+    return overloaded;
+}
 
-        for (auto& directory: directories)
-        {
-            directory.update(deltaTime);
-        }
+const Profiler& Simulation::getProfiler() const
+{
+    return profiler;
+}
 
-        assignFiles();
+const TimeSeriesRecorder& Simulation::getTimeSeries() const
+{
+    return timeSeries;
+}
 
-        processedFilesCount = 0;
-        totalWaitTime = 0;
-        for (auto& customer: customers)
-        {
-            processedFilesCount += customer->getProcessedFilesCount();
-            totalWaitTime += customer->getTotalWaitTime();
-        }
+std::shared_ptr<const SimulationSnapshot> Simulation::getSnapshot() const
+{
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    return snapshot;
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(timeStep * 1000)));
+bool Simulation::postCommand(const SimulationCommand& command)
+{
+    return commandQueue.tryPush(command);
+}
 
-        if (allFilesProcessed())
-        {
-            break;
-        }
+bool Simulation::setSpeed(double speedFactor)
+{
+    // Multiple of real time; Unthrottled runs steps back to back
+    if (speedFactor != Unthrottled)
+    {
+        speedFactor = std::clamp(speedFactor, MinSpeed, MaxSpeed);
     }
 
-    running = false;
+    if (running)
+    {
+        auto command = SimulationCommand{CommandType::SetSpeed};
+        command.speed = speedFactor;
+        return postCommand(command);
+    }
+
+    simulationSpeed = speedFactor;
+    return true;
 }
 
-void Simulation::generateCustomers(int customerCount)
+void Simulation::setSeed(unsigned int seed)
 {
-    auto rd = std::random_device{};
-    auto gen = std::mt19937{rd()};
-    auto fileCountDist = std::uniform_int_distribution<>{3, 10};
-    auto fileSizeDist = std::uniform_int_distribution<>{1, 100};
+    // 0 draws a fresh seed from std::random_device on every initialize()
+    this->seed = seed;
+}
 
-    for (int i = 0; i < customerCount; i++)
+void Simulation::setSchedulingMode(SchedulingMode mode)
+{
+    if (running)
     {
-        auto customer = new Customer{i + 1};
-        int fileCount = fileCountDist(gen);
-        for (int j = 0; j < fileCount; j++)
+        return;
+    }
+
+    schedulingMode = mode;
+}
+
+void Simulation::setThreadCount(int threadCount)
+{
+    if (running)
+    {
+        return;
+    }
+
+    if (threadCount <= 1)
+    {
+        workerPool.reset();
+    } else if (getThreadCount() != threadCount)
+    {
+        workerPool = std::make_unique<WorkerPool>(threadCount);
+    }
+}
+
+void Simulation::setWorkloadSpec(const WorkloadSpec& spec)
+{
+    if (running)
+    {
+        return;
+    }
+
+    workloadSpec = spec;
+}
+
+bool Simulation::setTraceReplay(const std::string& tracePath, std::string& error)
+{
+    if (running)
+    {
+        error = "cannot change the workload while running";
+        return false;
+    }
+
+    auto source = std::make_unique<TraceReplaySource>();
+    if (!source->open(tracePath, error))
+    {
+        return false;
+    }
+
+    traceReplay = std::move(source);
+    return true;
+}
+
+std::uint64_t Simulation::getSkippedTraceRecordCount() const
+{
+    return skippedTraceRecords;
+}
+
+void Simulation::clearTraceReplay()
+{
+    if (running)
+    {
+        return;
+    }
+
+    traceReplay.reset();
+}
+
+void Simulation::setBandwidthConfig(const BandwidthConfig& config)
+{
+    if (running)
+    {
+        return;
+    }
+
+    bandwidthConfig = config;
+    rebuildBandwidthPools();
+}
+
+void Simulation::rebuildBandwidthPools()
+{
+    bandwidthPools.clear();
+    if (bandwidthConfig.enabled)
+    {
+        for (int i = 0; i < std::max(1, bandwidthConfig.poolCount); i++)
         {
-            int fileSize = fileSizeDist(gen);
-            customer->addFile(fileSize);
+            bandwidthPools.push_back(std::make_unique<BandwidthPool>(
+                bandwidthConfig.poolBandwidth, bandwidthConfig.perDirectoryCap));
         }
-        customers.push_back(customer);
     }
 
-    for (auto& customer: customers)
+    for (int i = 0; i < static_cast<int>(directories.size()); i++)
     {
-        customer->updatePriorities(static_cast<int>(customers.size()));
+        directories[i].setBandwidthPool(bandwidthPoolFor(i));
     }
 }
 
-void Simulation::assignFiles()
+BandwidthPool* Simulation::bandwidthPoolFor(int directoryIndex) const
 {
-    for (auto& directory: directories)
+    if (bandwidthPools.empty())
     {
-        if (!directory.isProcessing())
-        {
-            Customer* bestCustomer = nullptr;
-            File* bestFile = nullptr;
-            
-            double highestPriority = -1.0;
+        return nullptr;
+    }
+    return bandwidthPools[directoryIndex % bandwidthPools.size()].get();
+}
 
-            for (auto& customer: customers)
-            {
-                if (customer->getPendingFilesCount() > 0)
-                {
-                    auto nextFile = customer->getNextFile();
-                    if (nextFile && nextFile->getPriority() > highestPriority)
-                    {
-                        if (bestFile)
-                        {
-                            bestCustomer->addFile(bestFile);
-                        }
-                        bestCustomer = customer;
-                        bestFile = nextFile;
-                        highestPriority = nextFile->getPriority();
-                    } else if (nextFile)
-                    {
-                        customer->addFile(nextFile);
-                    }
-                }
-            }
+void Simulation::setCompletionObserver(CompletionObserver observer)
+{
+    if (running)
+    {
+        return;
+    }
 
-            if (bestCustomer && bestFile)
-            {
-                directory.assignFile(bestCustomer, bestFile);
-            }
-        }
+    completionObserver = std::move(observer);
+}
+
+void Simulation::setPipeline(const PipelineConfig& config)
+{
+    if (running)
+    {
+        return;
     }
+
+    pipelineConfig = config;
 }
 
-bool Simulation::allFilesProcessed() const
+const TransferPipeline& Simulation::getPipeline() const
 {
+    return pipeline;
+}
+
+void Simulation::setDedupConfig(const DedupConfig& config)
+{
+    if (running)
+    {
+        return;
+    }
+
+    dedupConfig = config;
+}
+
+const DedupCache* Simulation::getDedupCache() const
+{
+    return dedupCache.get();
+}
+
+void Simulation::setSteadyStateConfig(const SteadyStateConfig& config)
+{
+    if (running)
+    {
+        return;
+    }
+
+    steadyStateConfig = config;
+}
+
+const SteadyStateDetector& Simulation::getSteadyState() const
+{
+    return steadyState;
+}
+
+void Simulation::setPublishCustomers(bool publish)
+{
+    if (running)
+    {
+        return;
+    }
+
+    publishCustomers = publish;
+}
+
+void Simulation::setDetailCustomer(int index)
+{
+    detailCustomer = index;
+
+    // Nothing else publishes while stopped, and nothing else touches the
+    // customers either
+    if (!running)
+    {
+        publishSnapshot();
+    }
+}
+
+void Simulation::setCustomerBehavior(CustomerBehavior behavior)
+{
+    if (running)
+    {
+        return;
+    }
+
+    customerBehavior = std::move(behavior);
+}
+
+File* Simulation::submitFile(Customer& customer, int size)
+{
+    auto file = customer.submitFile(size);
+    file->markEnqueued(elapsedTime);
+    if (schedulingMode == SchedulingMode::WorkStealing)
+    {
+        directories[homeDirectoryIndex(&customer)].enqueueLocal(&customer, file);
+    }
+    return file;
+}
+
+void Simulation::simulationLoop()
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Steps are paced against absolute deadlines so sleep overshoot and step
+    // cost do not accumulate. Missed deadlines are caught up by stepping
+    // without sleeping; beyond MaxLag the backlog is dropped and the run is
+    // flagged as overloaded.
+    const auto MaxLag = std::chrono::milliseconds(250);
+    const auto SnapshotInterval = std::chrono::milliseconds(16);
+    const auto SpeedWindow = std::chrono::milliseconds(500);
+
+    auto deadline = Clock::now();
+    auto lastSnapshot = Clock::time_point{};
+    auto windowStart = Clock::now();
+    double windowStartTime = elapsedTime;
+    double pacedSpeed = simulationSpeed;
+
+    publishSnapshot();
+
+    while (running && !stopRequested)
+    {
+        processCommands();
+
+        if (paused)
+        {
+            // Commands are polled rather than waited on so posting one never
+            // has to wake or lock anything
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            deadline = Clock::now();
+            windowStart = deadline;
+            windowStartTime = elapsedTime;
+            if (Clock::now() - lastSnapshot >= SnapshotInterval)
+            {
+                publishSnapshot();
+                lastSnapshot = Clock::now();
+            }
+            continue;
+        }
+
+        step();
+
+        double speed = simulationSpeed;
+        if (speed != pacedSpeed)
+        {
+            pacedSpeed = speed;
+            deadline = Clock::now();
+        }
+
+        auto now = Clock::now();
+        if (speed != Unthrottled)
+        {
+            deadline += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(timeStep / speed));
+
+            if (now < deadline)
+            {
+                // Sleep in slices so stop() is not held up at slow speeds
+                while (now < deadline && !stopRequested)
+                {
+                    std::this_thread::sleep_until(std::min(deadline, now + std::chrono::milliseconds(10)));
+                    now = Clock::now();
+                }
+                overloaded = false;
+            } else if (now - deadline > MaxLag)
+            {
+                deadline = now;
+                overloaded = true;
+            }
+        }
+
+        bool completed = allFilesProcessed() || reachedSteadyState();
+        if (now - windowStart >= SpeedWindow || (completed && now > windowStart))
+        {
+            double realSeconds = std::chrono::duration<double>(now - windowStart).count();
+            achievedSpeed = (elapsedTime - windowStartTime) / realSeconds;
+            windowStart = now;
+            windowStartTime = elapsedTime;
+        }
+
+        if (completed || now - lastSnapshot >= SnapshotInterval)
+        {
+            publishSnapshot();
+            lastSnapshot = now;
+        }
+
+        if (completed)
+        {
+            break;
+        }
+    }
+
+    running = false;
+}
+
+void Simulation::processCommands()
+{
+    auto command = SimulationCommand{};
+    while (commandQueue.tryPop(command))
+    {
+        scheduledCommands.push(ScheduledCommand{command, commandSequence++});
+    }
+
+    while (!scheduledCommands.empty() &&
+        scheduledCommands.top().command.effectiveTime <= elapsedTime)
+    {
+        applyCommand(scheduledCommands.top().command);
+        scheduledCommands.pop();
+    }
+}
+
+void Simulation::applyCommand(const SimulationCommand& command)
+{
+    switch (command.type)
+    {
+    case CommandType::Pause:
+        paused = true;
+        break;
+    case CommandType::Resume:
+        paused = false;
+        break;
+    case CommandType::SetSpeed:
+        simulationSpeed = command.speed;
+        break;
+    case CommandType::AddDirectory:
+        addDirectory();
+        break;
+    case CommandType::RemoveDirectory:
+        removeDirectory(command.directoryId);
+        break;
+    case CommandType::InjectBurst:
+        injectBurst(command.fileCount);
+        break;
+    case CommandType::SetPolicy:
+        changePolicy(command.policy);
+        break;
+    }
+}
+
+void Simulation::addDirectory()
+{
+    directories.push_back(nextDirectoryId++);
+    directories.back().setBandwidthPool(bandwidthPoolFor(static_cast<int>(directories.size()) - 1));
+    directories.back().setDedupCache(dedupCache.get());
+}
+
+void Simulation::removeDirectory(int directoryId)
+{
+    if (directories.size() <= 1)
+    {
+        return;
+    }
+
+    // 0 removes the most recently added directory
+    auto it = directories.end() - 1;
+    if (directoryId != 0)
+    {
+        it = std::find_if(directories.begin(), directories.end(), [directoryId](const Directory& directory)
+            {
+                return directory.getId() == directoryId;
+            });
+        if (it == directories.end())
+        {
+            return;
+        }
+    }
+
+    // An interrupted transfer goes back to the head of its customer's queue,
+    // and with work stealing also to the head of its home directory's queue
+    auto interrupted = QueuedFile{nullptr, nullptr};
+    if (it->isProcessing())
+    {
+        interrupted = QueuedFile{it->getCurrentCustomer(), it->getCurrentFile()};
+        interrupted.customer->addFile(interrupted.file);
+    }
+
+    auto orphaned = std::vector<QueuedFile>{};
+    auto queued = QueuedFile{nullptr, nullptr};
+    while (it->popLocal(queued))
+    {
+        orphaned.push_back(queued);
+    }
+
+    // A held file has already been transferred, so it moves on even if that
+    // overfills the first stage's buffer for a while
+    if (auto held = it->getHeldFile())
+    {
+        pipeline.forceAccept(held, elapsedTime);
+    }
+
+    it->reset();
+    directories.erase(it);
+
+    for (auto& file: orphaned)
+    {
+        directories[homeDirectoryIndex(file.customer)].enqueueLocal(file.customer, file.file);
+    }
+    if (interrupted.file && schedulingMode == SchedulingMode::WorkStealing)
+    {
+        directories[homeDirectoryIndex(interrupted.customer)].requeueLocal(interrupted.customer, interrupted.file);
+    }
+}
+
+void Simulation::injectBurst(int fileCount)
+{
+    if (customers.empty())
+    {
+        return;
+    }
+
+    auto customerDist = std::uniform_int_distribution<std::size_t>{0, customers.size() - 1};
+    auto fileSizeDist = std::uniform_int_distribution<>{1, 100};
+    for (int i = 0; i < fileCount; i++)
+    {
+        submitFile(*customers[customerDist(commandRandom)], fileSizeDist(commandRandom));
+    }
+}
+
+void Simulation::changePolicy(SchedulingMode mode)
+{
+    if (mode == schedulingMode)
+    {
+        return;
+    }
+
+    for (auto& directory: directories)
+    {
+        directory.clearLocalQueue();
+    }
+
+    schedulingMode = mode;
+    if (schedulingMode == SchedulingMode::WorkStealing)
+    {
+        partitionPendingFiles();
+    }
+}
+
+void Simulation::step()
+{
+    double deltaTime = timeStep;
+    elapsedTime += deltaTime;
+
+    int activeCustomerCount = 0;
+    {
+        FTS_PROFILE_PHASE(profiler, ProfilePhase::WaitUpdate);
+        activeCustomerCount = updateWaitTimes(deltaTime);
+
+        // Arrivals join after the wait update so they are not charged the
+        // whole tick
+        if (traceReplay)
+        {
+            replayArrivals();
+        }
+    }
+
+    {
+        FTS_PROFILE_PHASE(profiler, ProfilePhase::PriorityUpdate);
+        runCustomerPhase([activeCustomerCount](Customer& customer, BlockTotals&)
+            {
+                customer.updatePriorities(activeCustomerCount);
+            });
+    }
+
+    // Completions and scripts mutate shared customer queues, so they stay on
+    // the simulation thread. Dispatch only fans out its candidate search.
+    {
+        FTS_PROFILE_PHASE(profiler, ProfilePhase::DirectoryUpdate);
+        for (auto& pool: bandwidthPools)
+        {
+            pool->advance(deltaTime);
+        }
+
+        if (pipeline.isEnabled())
+        {
+            pipeline.advance(elapsedTime, deltaTime);
+            releaseHeldFiles();
+            reportPipelineExits();
+        }
+
+        for (auto& directory: directories)
+        {
+            auto customer = directory.getCurrentCustomer();
+            if (auto completed = directory.update(deltaTime))
+            {
+                if (pipeline.isEnabled())
+                {
+                    if (!pipeline.tryAccept(completed, elapsedTime))
+                    {
+                        directory.holdFile(completed);
+                    }
+                } else {
+                    completed->markExited(elapsedTime);
+                }
+                timeSeries.recordCompletion(completed->getWaitTime());
+                if (steadyStateConfig.enabled)
+                {
+                    steadyState.observe(completed->getWaitTime(), elapsedTime);
+                    steadyStateWaits.push_back(completed->getWaitTime());
+                }
+                if (completionObserver)
+                {
+                    auto result = FileResult{elapsedTime, directory.getId(), customer ? customer->getId() : 0,
+                                             completed->getId(), completed->getSize(), completed->getWaitTime(),
+                                             completed->getStartTime(), completed->getDispatchPriority(),
+                                             completed->getEnqueueTime(), completed->getExitTime()};
+                    if (pipeline.isEnabled())
+                    {
+                        pipelineResults[completed] = result;
+                    } else {
+                        completionObserver(result);
+                    }
+                }
+                // With a pipeline, scripts hear of the file when it leaves
+                if (!pipeline.isEnabled())
+                {
+                    scripts.fileCompleted(completed);
+                }
+            }
+        }
+
+        scripts.run(elapsedTime);
+    }
+
+    {
+        FTS_PROFILE_PHASE(profiler, ProfilePhase::AssignFiles);
+        if (schedulingMode == SchedulingMode::WorkStealing)
+        {
+            assignFilesWorkStealing();
+        } else {
+            assignFiles();
+        }
+    }
+
+    {
+        FTS_PROFILE_PHASE(profiler, ProfilePhase::Aggregation);
+        int pendingFilesCount = aggregateCustomers();
+
+        if (pipeline.isEnabled())
+        {
+            int busyDirectories = 0;
+            int blockedDirectories = 0;
+            for (auto& directory: directories)
+            {
+                busyDirectories += directory.isProcessing() ? 1 : 0;
+                blockedDirectories += directory.isBlocked() ? 1 : 0;
+            }
+            pipeline.recordEntryStage(static_cast<int>(directories.size()), busyDirectories,
+                                      blockedDirectories, pendingFilesCount, deltaTime);
+        }
+
+        if (timeSeries.isSampleDue(elapsedTime))
+        {
+            int busyDirectories = 0;
+            for (auto& directory: directories)
+            {
+                if (directory.isProcessing())
+                {
+                    busyDirectories++;
+                }
+            }
+            timeSeries.sample(elapsedTime, pendingFilesCount, busyDirectories, processedFilesCount);
+        }
+    }
+}
+
+void Simulation::publishSnapshot()
+{
+    FTS_PROFILE_PHASE(profiler, ProfilePhase::SnapshotPublish);
+
+    auto next = std::make_shared<SimulationSnapshot>();
+    next->elapsedTime = elapsedTime;
+    next->processedFiles = processedFilesCount;
+    next->totalWaitTime = totalWaitTime;
+    next->requestedSpeed = simulationSpeed;
+    next->achievedSpeed = achievedSpeed;
+    next->overloaded = overloaded;
+    next->stealCount = stealCount;
+    next->locality = getLocality();
+    next->completed = allFilesProcessed() || reachedSteadyState();
+#if FTS_PROFILING
+    next->phaseStats = profiler.getStats();
+#endif
+
+    if (overviewSampleCount != timeSeries.getSampleCount())
+    {
+        timeSeriesOverview = std::make_shared<const std::vector<TimeSeriesBucket>>(timeSeries.getOverview());
+        overviewSampleCount = timeSeries.getSampleCount();
+    }
+    next->timeSeries = timeSeriesOverview;
+
+    next->directories.reserve(directories.size());
+    for (auto& directory: directories)
+    {
+        auto customer = directory.getCurrentCustomer();
+        auto file = directory.getCurrentFile();
+        next->directories.push_back(DirectorySnapshot{
+            directory.getId(),
+            directory.isProcessing(),
+            directory.getProgress(),
+            customer ? customer->getId() : 0,
+            file ? file->getId() : 0,
+            file ? file->getSize() : 0
+        });
+    }
+
+    if (publishCustomers)
+    {
+        next->customers.reserve(customers.size());
+        for (const auto* customer: customers)
+        {
+            next->customers.push_back(CustomerSnapshot{
+                customer->getId(),
+                customer->getPendingFilesCount(),
+                customer->getProcessedFilesCount(),
+                customer->getTotalWaitTime()
+            });
+        }
+    }
+
+    int detail = detailCustomer;
+    if (detail >= 0 && detail < static_cast<int>(customers.size()))
+    {
+        const auto* customer = customers[detail];
+        next->detailCustomer = detail;
+        next->detailFiles.reserve(customer->getPendingFilesCount());
+        for (int i = 0; i < customer->getPendingFilesCount(); i++)
+        {
+            const auto& file = customer->getPendingFile(i);
+            next->detailFiles.push_back(FileSnapshot{file.getId(), file.getSize(), file.getPriority(), file.getWaitTime()});
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    snapshot = std::move(next);
+}
+
+void Simulation::generateCustomers(int customerCount, int firstKept, int keptCount)
+{
+    auto rd = std::random_device{};
+    auto gen = std::mt19937{seed != 0 ? seed : rd()};
+    auto fileCountDist = std::uniform_int_distribution<>{workloadSpec.minFilesPerCustomer, workloadSpec.maxFilesPerCustomer};
+    auto fileSizeDist = std::uniform_int_distribution<>{workloadSpec.minFileSize, workloadSpec.maxFileSize};
+    auto repeatDist = std::uniform_real_distribution<>{0.0, 1.0};
+    // Content key and size of every file so far; repeats draw from it
+    auto contents = std::vector<std::pair<std::uint64_t, int>>{};
+
+    if (traceReplay)
+    {
+        traceReplay->rewind();
+        skippedTraceRecords = 0;
+        return;
+    }
+
+    for (int i = 0; i < customerCount; i++)
+    {
+        // Customers outside the slice still draw from the generator, so every
+        // slice sees the same workload
+        bool kept = i >= firstKept && i < firstKept + keptCount;
+        auto customer = new Customer{i + 1};
+        if (customerBehavior)
+        {
+            // Scripted customers submit their own files over time
+            auto scriptSeed = gen();
+            if (kept)
+            {
+                auto context = std::make_unique<ScriptContext>(*this, scripts, *customer, scriptSeed);
+                scripts.spawn(std::move(context), customerBehavior);
+            }
+        } else {
+            int fileCount = fileCountDist(gen);
+            for (int j = 0; j < fileCount; j++)
+            {
+                int fileSize = fileSizeDist(gen);
+                if (workloadSpec.repeatProbability <= 0.0)
+                {
+                    customer->addFile(fileSize);
+                    continue;
+                }
+
+                auto content = std::make_pair(static_cast<std::uint64_t>(contents.size() + 1), fileSize);
+                if (!contents.empty() && repeatDist(gen) < workloadSpec.repeatProbability)
+                {
+                    auto pick = std::uniform_int_distribution<std::size_t>{0, contents.size() - 1};
+                    content = contents[pick(gen)];
+                }
+                contents.push_back(content);
+                customer->addFile(content.second, content.first);
+            }
+        }
+
+        if (kept)
+        {
+            customers.push_back(customer);
+        } else {
+            delete customer;
+        }
+    }
+
+    for (auto& customer: customers)
+    {
+        customer->updatePriorities(static_cast<int>(customers.size()));
+    }
+}
+
+void Simulation::clearCustomers()
+{
+    // Script frames and files in the pipeline reference their customers,
+    // so they go first
+    scripts.clear();
+    pipeline.clear();
+    pipelineResults.clear();
+
+    for (auto& customer: customers)
+    {
+        delete customer;
+    }
+    customers.clear();
+    traceCustomers.clear();
+}
+
+void Simulation::replayArrivals()
+{
+    traceReplay->advanceTo(elapsedTime, [this](const TraceRecord& record)
+        {
+            // Traces not written by convertCsvTrace may hold values that do
+            // not fit an int
+            if (record.customerId > INT_MAX || record.size > INT_MAX)
+            {
+                skippedTraceRecords++;
+                return;
+            }
+
+            auto& customer = traceCustomers[record.customerId];
+            if (!customer)
+            {
+                customer = new Customer{static_cast<int>(record.customerId)};
+                customers.push_back(customer);
+            }
+
+            // Credit the part of this tick the file already spent waiting
+            auto file = submitFile(*customer, static_cast<int>(record.size));
+            file->markEnqueued(record.timestamp);
+            file->updateWaitTime(elapsedTime - record.timestamp);
+        });
+}
+
+void Simulation::assignFiles()
+{
+    // Idle directories pick in board order, each taking the highest-priority
+    // head file, with ties going to the earliest customer. Every block keeps
+    // its own best candidate and only the block that supplied a file is
+    // rescanned, so the choice matches one full scan per directory for any
+    // thread count.
+    auto idle = std::count_if(directories.begin(), directories.end(), [](const Directory& directory)
+        {
+            return !directory.isProcessing() && !directory.isBlocked();
+        });
+    if (idle == 0 || customers.empty())
+    {
+        return;
+    }
+
+    computeBlockCandidates();
+    for (auto& directory: directories)
+    {
+        if (directory.isProcessing() || directory.isBlocked())
+        {
+            continue;
+        }
+
+        int block = bestCandidateBlock();
+        if (block < 0)
+        {
+            return;
+        }
+
+        auto customer = blockCandidates[block].customer;
+        auto file = customer->getNextFile();
+        file->markDispatched(elapsedTime);
+        directory.assignFile(customer, file);
+        blockCandidates[block] = bestCandidateInBlock(block);
+    }
+}
+
+void Simulation::computeBlockCandidates()
+{
+    int blockCount = (static_cast<int>(customers.size()) + CustomerBlockSize - 1) / CustomerBlockSize;
+    blockCandidates.resize(blockCount);
+    runBlocks(blockCount, [this](int block)
+        {
+            blockCandidates[block] = bestCandidateInBlock(block);
+        });
+}
+
+int Simulation::bestCandidateBlock() const
+{
+    int bestBlock = -1;
+    double highestPriority = -1.0;
+    for (int block = 0; block < static_cast<int>(blockCandidates.size()); block++)
+    {
+        if (blockCandidates[block].customer && blockCandidates[block].priority > highestPriority)
+        {
+            bestBlock = block;
+            highestPriority = blockCandidates[block].priority;
+        }
+    }
+    return bestBlock;
+}
+
+Simulation::BlockCandidate Simulation::bestCandidateInBlock(int block) const
+{
+    auto candidate = BlockCandidate{nullptr, -1.0};
+    int end = std::min(static_cast<int>(customers.size()), (block + 1) * CustomerBlockSize);
+    for (int i = block * CustomerBlockSize; i < end; i++)
+    {
+        auto customer = customers[i];
+        if (customer->getPendingFilesCount() > 0 && customer->getPendingFile(0).getPriority() > candidate.priority)
+        {
+            candidate = BlockCandidate{customer, customer->getPendingFile(0).getPriority()};
+        }
+    }
+    return candidate;
+}
+
+int Simulation::updateWaitTimes(double deltaTime)
+{
+    runCustomerPhase([deltaTime](Customer& customer, BlockTotals& totals)
+        {
+            customer.updateWaitTimes(deltaTime);
+            if (!customer.isCompleted()) {
+                totals.activeCustomers++;
+            }
+        });
+
+    int activeCustomerCount = 0;
+    for (auto& totals: blockTotals)
+    {
+        activeCustomerCount += totals.activeCustomers;
+    }
+    return activeCustomerCount;
+}
+
+int Simulation::aggregateCustomers()
+{
+    runCustomerPhase([](Customer& customer, BlockTotals& totals)
+        {
+            totals.processedFiles += customer.getProcessedFilesCount();
+            totals.pendingFiles += customer.getPendingFilesCount();
+            totals.waitTime += customer.getTotalWaitTime();
+        });
+
+    int pendingFilesCount = 0;
+    processedFilesCount = 0;
+    totalWaitTime = 0;
+    for (auto& totals: blockTotals)
+    {
+        processedFilesCount += totals.processedFiles;
+        pendingFilesCount += totals.pendingFiles;
+        totalWaitTime += totals.waitTime;
+    }
+    return pendingFilesCount;
+}
+
+int Simulation::beginShardTick(std::vector<ShardFile>& completed)
+{
+    elapsedTime += timeStep;
+    int activeCustomerCount = updateWaitTimes(timeStep);
+
+    shardTransfers.resize(directories.size());
+    shardProxies.resize(directories.size());
+    for (std::size_t i = 0; i < directories.size(); i++)
+    {
+        if (directories[i].update(timeStep))
+        {
+            completed.push_back(shardTransfers[i]);
+            shardProxies[i].reset();
+        }
+    }
+    return activeCustomerCount;
+}
+
+bool Simulation::completeShardFile(const ShardFile& file, double& waitTime)
+{
+    auto key = (static_cast<std::uint64_t>(file.customerId) << 32) | static_cast<std::uint32_t>(file.fileId);
+    auto it = shardInFlight.find(key);
+    if (it == shardInFlight.end())
+    {
+        return false;
+    }
+
+    it->second.customer->fileProcessed(it->second.file);
+    waitTime = it->second.file->getWaitTime();
+    shardInFlight.erase(it);
+    return true;
+}
+
+void Simulation::offerShardFiles(int activeCustomerCount, int limit, std::vector<ShardFile>& offered)
+{
+    runCustomerPhase([activeCustomerCount](Customer& customer, BlockTotals&)
+        {
+            customer.updatePriorities(activeCustomerCount);
+        });
+
+    shardOffered.clear();
+    if (limit <= 0 || customers.empty())
+    {
+        return;
+    }
+
+    computeBlockCandidates();
+    while (static_cast<int>(shardOffered.size()) < limit)
+    {
+        int block = bestCandidateBlock();
+        if (block < 0)
+        {
+            break;
+        }
+
+        auto customer = blockCandidates[block].customer;
+        auto file = customer->getNextFile();
+        shardOffered.push_back(QueuedFile{customer, file});
+        offered.push_back(ShardFile{customer->getId(), file->getId(), file->getSize(), file->getPriority()});
+        blockCandidates[block] = bestCandidateInBlock(block);
+    }
+}
+
+void Simulation::takeShardFiles(int count)
+{
+    count = std::min(count, static_cast<int>(shardOffered.size()));
+    for (int i = 0; i < count; i++)
+    {
+        auto& offered = shardOffered[i];
+        offered.file->markDispatched(elapsedTime);
+        auto key = (static_cast<std::uint64_t>(offered.customer->getId()) << 32)
+            | static_cast<std::uint32_t>(offered.file->getId());
+        shardInFlight[key] = offered;
+    }
+
+    // Heads go back newest first, which restores every queue exactly
+    for (int i = static_cast<int>(shardOffered.size()) - 1; i >= count; i--)
+    {
+        shardOffered[i].customer->addFile(shardOffered[i].file);
+    }
+    shardOffered.clear();
+}
+
+bool Simulation::assignShardFile(const ShardFile& file)
+{
+    shardTransfers.resize(directories.size());
+    shardProxies.resize(directories.size());
+    for (std::size_t i = 0; i < directories.size(); i++)
+    {
+        if (!directories[i].isProcessing() && !directories[i].isBlocked())
+        {
+            // The real file stays with its customer's shard; the transfer
+            // only needs the size
+            shardProxies[i] = std::make_unique<File>(file.fileId, file.size);
+            shardTransfers[i] = file;
+            return directories[i].assignFile(nullptr, shardProxies[i].get());
+        }
+    }
+    return false;
+}
+
+int Simulation::getIdleDirectoryCount() const
+{
+    return static_cast<int>(std::count_if(directories.begin(), directories.end(), [](const Directory& directory)
+        {
+            return !directory.isProcessing() && !directory.isBlocked();
+        }));
+}
+
+void Simulation::finishShardTick()
+{
+    aggregateCustomers();
+}
+
+void Simulation::assignFilesWorkStealing()
+{
+    for (auto& directory: directories)
+    {
+        if (directory.isProcessing() || directory.isBlocked())
+        {
+            continue;
+        }
+
+        auto queued = QueuedFile{nullptr, nullptr};
+        if (directory.popLocal(queued))
+        {
+            localDispatchCount++;
+        } else {
+            Directory* victim = nullptr;
+            for (auto& peer: directories)
+            {
+                if (&peer != &directory && peer.getLocalQueueSize() > 0 &&
+                    (!victim || peer.getLocalQueueSize() > victim->getLocalQueueSize()))
+                {
+                    victim = &peer;
+                }
+            }
+
+            if (!victim || !victim->stealLocal(queued))
+            {
+                continue;
+            }
+            stealCount++;
+        }
+
+        queued.customer->takeFile(queued.file);
+        queued.file->markDispatched(elapsedTime);
+        directory.assignFile(queued.customer, queued.file);
+    }
+}
+
+void Simulation::partitionPendingFiles()
+{
+    // Interleave customers so each local queue is served round-robin rather
+    // than draining one customer's whole backlog before the next.
+    bool enqueued = true;
+    for (int rank = 0; enqueued; rank++)
+    {
+        enqueued = false;
+        for (auto& customer: customers)
+        {
+            if (rank < customer->getPendingFilesCount())
+            {
+                auto& file = customer->getPendingFile(rank);
+                directories[homeDirectoryIndex(customer)].enqueueLocal(customer, &file);
+                enqueued = true;
+            }
+        }
+    }
+}
+
+void Simulation::reportPipelineExits()
+{
+    exitedFiles.clear();
+    pipeline.takeExitedFiles(exitedFiles);
+    for (auto file: exitedFiles)
+    {
+        scripts.fileCompleted(file);
+        if (!completionObserver)
+        {
+            continue;
+        }
+
+        auto pending = pipelineResults.find(file);
+        if (pending == pipelineResults.end())
+        {
+            continue;
+        }
+        pending->second.exitTime = file->getExitTime();
+        completionObserver(pending->second);
+        pipelineResults.erase(pending);
+    }
+}
+
+void Simulation::releaseHeldFiles()
+{
+    // Directories retry in board order when the first buffer frees up
+    for (auto& directory: directories)
+    {
+        if (directory.isBlocked() && pipeline.tryAccept(directory.getHeldFile(), elapsedTime))
+        {
+            directory.releaseHeldFile();
+        }
+    }
+}
+
+int Simulation::homeDirectoryIndex(const Customer* customer) const
+{
+    // Multiplicative hash so consecutive customer ids spread across directories
+    auto hash = static_cast<unsigned int>(customer->getId()) * 2654435761u;
+    return static_cast<int>(hash % directories.size());
+}
+
+bool Simulation::reachedSteadyState() const
+{
+    return steadyStateConfig.enabled && steadyStateConfig.stopWhenPrecise && steadyState.hasConverged();
+}
+
+bool Simulation::allFilesProcessed() const
+{
+    if (scripts.hasLiveScripts()) {
+        return false;
+    }
+
+    if (traceReplay && !traceReplay->isExhausted()) {
+        return false;
+    }
+
+    if (pipeline.isEnabled()) {
+        if (!pipeline.isDrained()) {
+            return false;
+        }
+        for (auto& directory : directories) {
+            if (directory.isBlocked()) {
+                return false;
+            }
+        }
+    }
+
     for (auto& customer : customers) {
         if (!customer->isCompleted()) {
             return false;
@@ -1,27 +1,115 @@
 #pragma once
 
 #include "Customer.hpp"
+#include "CustomerScript.hpp"
 #include "Directory.hpp"
-#include <condition_variable>
+#include "MpscQueue.hpp"
+#include "Profiler.hpp"
+#include "SimulationSnapshot.hpp"
+#include "SteadyStateDetector.hpp"
+#include "TimeSeriesRecorder.hpp"
+#include "TraceReplaySource.hpp"
+#include "TransferPipeline.hpp"
+#include "WorkerPool.hpp"
+#include "WorkloadSpec.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <queue>
+#include <random>
 #include <thread>
+#include <unordered_map>
+
+enum class SchedulingMode
+{
+    CentralGreedy,
+    WorkStealing
+};
+
+enum class CommandType
+{
+    Pause,
+    Resume,
+    SetSpeed,
+    AddDirectory,
+    RemoveDirectory,
+    InjectBurst,
+    SetPolicy
+};
+
+// Control message from another thread. It is applied at the first tick
+// boundary whose simulated time is >= effectiveTime; 0 means the next one.
+struct SimulationCommand
+{
+    CommandType type = CommandType::Pause;
+    double effectiveTime = 0.0;
+    double speed = 1.0;
+    int directoryId = 0;
+    int fileCount = 0;
+    SchedulingMode policy = SchedulingMode::CentralGreedy;
+};
+
+// One finished file, reported when it leaves the system: when its directory
+// completes it, or with a pipeline, when it leaves the last stage.
+// completionTime is always the directory's.
+struct FileResult
+{
+    double completionTime;
+    int directoryId;
+    int customerId;
+    int fileId;
+    int size;
+    double waitTime;
+    double startTime;
+    double dispatchPriority;
+    double enqueueTime;
+    double exitTime;
+};
+
+using CompletionObserver = std::function<void(const FileResult&)>;
+
+// A file crossing between shards: offered by the shard that owns its
+// customer, transferred by the shard that owns the directory it went to.
+struct ShardFile
+{
+    int customerId;
+    int fileId;
+    int size;
+    double priority;
+};
 
 class Simulation
 {
 public:
+    static constexpr double MinSpeed = 0.1;
+    static constexpr double MaxSpeed = 10000.0;
+    static constexpr double Unthrottled = 0.0;
+
     Simulation(int directoryCount);
     ~Simulation();
 
     void initialize(int customerCount);
+    // Generates the same workload as initialize(customerCount) but keeps only
+    // customers [firstKept, firstKept + keptCount), so shards of one run split
+    // a single workload between them
+    void initializeSlice(int customerCount, int firstKept, int keptCount);
     void start();
     void stop();
-    void pause();
-    void resume();
+    // Both return false if the command queue is full
+    bool pause();
+    bool resume();
     void reset();
+    void step();
 
     bool isRunning() const;
     bool isPaused() const;
     bool isCompleted() const;
+    bool allFilesProcessed() const;
+    // True once steady-state detection asked to stop early and got there
+    bool reachedSteadyState() const;
 
     int getCustomersCount() const;
     int getDirectoriesCount() const;
@@ -30,22 +118,146 @@ public:
     double getElapsedTime() const;
     int getProcessedFilesCount() const;
     double getTotalWaitTime() const;
+    double getWaitTimePercentile(double fraction) const;
+    // Over completions after the detected warm-up; the whole run when
+    // steady-state detection is off
+    double getSteadyStateWaitPercentile(double fraction) const;
+    SchedulingMode getSchedulingMode() const;
+    int getStealCount() const;
+    int getLocalDispatchCount() const;
+    double getLocality() const;
+    int getThreadCount() const;
+    double getRequestedSpeed() const;
+    double getAchievedSpeed() const;
+    bool isOverloaded() const;
+    std::shared_ptr<const SimulationSnapshot> getSnapshot() const;
+    const Profiler& getProfiler() const;
+    const TimeSeriesRecorder& getTimeSeries() const;
+
+    // Never blocks; returns false if the command queue is full
+    bool postCommand(const SimulationCommand& command);
 
-    void setSpeed(int speed);
+    // Returns false if the simulation is running and the command queue is full
+    bool setSpeed(double speedFactor);
+    void setSeed(unsigned int seed);
+    void setSchedulingMode(SchedulingMode mode);
+    void setThreadCount(int threadCount);
+    void setCustomerBehavior(CustomerBehavior behavior);
+    void setWorkloadSpec(const WorkloadSpec& spec);
+    void setBandwidthConfig(const BandwidthConfig& config);
+    void setCompletionObserver(CompletionObserver observer);
+    // Stages every file passes through after its directory; empty disables
+    void setPipeline(const PipelineConfig& config);
+    const TransferPipeline& getPipeline() const;
+    // A fresh cache is created for every run; null when disabled
+    void setDedupConfig(const DedupConfig& config);
+    const DedupCache* getDedupCache() const;
+    void setSteadyStateConfig(const SteadyStateConfig& config);
+    const SteadyStateDetector& getSteadyState() const;
+    // Adds per-customer counters to every snapshot, for viewers
+    void setPublishCustomers(bool publish);
+    // Adds one customer's pending files to every snapshot; -1 for none.
+    // Safe to call from any thread.
+    void setDetailCustomer(int index);
+
+    // Replays arrivals from a binary trace instead of generating customers;
+    // customers are created as their first record arrives
+    bool setTraceReplay(const std::string& tracePath, std::string& error);
+    void clearTraceReplay();
+    // Records whose customer id or size does not fit in an int
+    std::uint64_t getSkippedTraceRecordCount() const;
+
+    // Adds a file to a customer's queue while the simulation is running
+    File* submitFile(Customer& customer, int size);
+
+    // Sharded execution. ShardedSimulation runs one central-greedy tick as a
+    // sequence of rounds and moves ShardFiles between them. Local directories
+    // only ever transfer files handed to them by assignShardFile.
+    //
+    // Advances the clock and wait times, then the directories. Returns the
+    // active customer count, taken before this tick's completions.
+    int beginShardTick(std::vector<ShardFile>& completed);
+    // Returns false for a file this shard did not dispatch
+    bool completeShardFile(const ShardFile& file, double& waitTime);
+    // Updates priorities for the run-wide active count, then offers up to
+    // limit head files in the order local greedy dispatch would take them
+    void offerShardFiles(int activeCustomerCount, int limit, std::vector<ShardFile>& offered);
+    // The first count offers were dispatched; the rest go back to their queues
+    void takeShardFiles(int count);
+    // Starts a transfer on the first idle directory in board order
+    bool assignShardFile(const ShardFile& file);
+    int getIdleDirectoryCount() const;
+    void finishShardTick();
 
 private:
+    // Customers are processed in fixed-size blocks and per-block partials are
+    // combined in block order, so totals are identical for any thread count.
+    static constexpr int CustomerBlockSize = 1024;
+
+    struct alignas(64) BlockTotals
+    {
+        int activeCustomers;
+        int processedFiles;
+        int pendingFiles;
+        double waitTime;
+    };
+
+    // Highest-priority head file within one customer block
+    struct alignas(64) BlockCandidate
+    {
+        Customer* customer;
+        double priority;
+    };
+
+    static constexpr std::size_t CommandQueueCapacity = 1024;
+
+    struct ScheduledCommand
+    {
+        SimulationCommand command;
+        unsigned long sequence;
+
+        bool operator>(const ScheduledCommand& other) const
+        {
+            return command.effectiveTime != other.command.effectiveTime
+                ? command.effectiveTime > other.command.effectiveTime
+                : sequence > other.sequence;
+        }
+    };
+
     void simulationLoop();
+    void processCommands();
+    void applyCommand(const SimulationCommand& command);
+    void addDirectory();
+    void removeDirectory(int directoryId);
+    void injectBurst(int fileCount);
+    void changePolicy(SchedulingMode mode);
+    void publishSnapshot();
+    template <typename Phase>
+    void runCustomerPhase(const Phase& phase);
+    template <typename Task>
+    void runBlocks(int blockCount, const Task& task);
+    BlockCandidate bestCandidateInBlock(int block) const;
+    void computeBlockCandidates();
+    int bestCandidateBlock() const;
+    int updateWaitTimes(double deltaTime);
+    int aggregateCustomers();
 
-    void generateCustomers(int customerCount);
+    void generateCustomers(int customerCount, int firstKept, int keptCount);
+    void clearCustomers();
+    void replayArrivals();
+    void rebuildBandwidthPools();
+    BandwidthPool* bandwidthPoolFor(int directoryIndex) const;
     void assignFiles();
-    bool allFilesProcessed() const;
+    void assignFilesWorkStealing();
+    void partitionPendingFiles();
+    void releaseHeldFiles();
+    void reportPipelineExits();
+    int homeDirectoryIndex(const Customer* customer) const;
 
     std::vector<Directory> directories;
     std::vector<Customer*> customers;
 
     std::thread simulationThread;
-    std::mutex simulationMutex;
-    std::condition_variable pauseCondition;
     std::atomic<bool> running;
     std::atomic<bool> paused;
     std::atomic<bool> stopRequested;
@@ -54,5 +266,90 @@ private:
     int processedFilesCount;
     double totalWaitTime;
     double timeStep;
-    double simulationSpeed;
-};
\ No newline at end of file
+    std::atomic<double> simulationSpeed;
+    std::atomic<double> achievedSpeed;
+    std::atomic<bool> overloaded;
+    unsigned int seed;
+
+    SchedulingMode schedulingMode;
+    int stealCount;
+    int localDispatchCount;
+
+    WorkloadSpec workloadSpec;
+    BandwidthConfig bandwidthConfig;
+    PipelineConfig pipelineConfig;
+    TransferPipeline pipeline;
+    SteadyStateConfig steadyStateConfig;
+    SteadyStateDetector steadyState;
+    // Waits in the order the detector saw them, so its warm-up can be cut
+    std::vector<double> steadyStateWaits;
+    DedupConfig dedupConfig;
+    std::unique_ptr<DedupCache> dedupCache;
+    std::vector<std::unique_ptr<BandwidthPool>> bandwidthPools;
+    CustomerBehavior customerBehavior;
+    CompletionObserver completionObserver;
+    // Results of files still in the pipeline, reported once they leave it
+    std::unordered_map<const File*, FileResult> pipelineResults;
+    std::vector<File*> exitedFiles;
+    bool publishCustomers;
+    std::atomic<int> detailCustomer;
+    std::unique_ptr<TraceReplaySource> traceReplay;
+    std::unordered_map<std::uint32_t, Customer*> traceCustomers;
+    std::uint64_t skippedTraceRecords;
+    ScriptScheduler scripts;
+
+    Profiler profiler;
+    TimeSeriesRecorder timeSeries;
+    std::shared_ptr<const std::vector<TimeSeriesBucket>> timeSeriesOverview;
+    int overviewSampleCount;
+    std::unique_ptr<WorkerPool> workerPool;
+    std::vector<BlockTotals> blockTotals;
+    std::vector<BlockCandidate> blockCandidates;
+
+    std::vector<QueuedFile> shardOffered;
+    std::unordered_map<std::uint64_t, QueuedFile> shardInFlight;
+    std::vector<ShardFile> shardTransfers;
+    std::vector<std::unique_ptr<File>> shardProxies;
+
+    MpscQueue<SimulationCommand> commandQueue;
+    std::priority_queue<ScheduledCommand, std::vector<ScheduledCommand>, std::greater<ScheduledCommand>> scheduledCommands;
+    unsigned long commandSequence;
+    int nextDirectoryId;
+    std::mt19937 commandRandom;
+
+    mutable std::mutex snapshotMutex;
+    std::shared_ptr<const SimulationSnapshot> snapshot;
+};
+
+template <typename Task>
+void Simulation::runBlocks(int blockCount, const Task& task)
+{
+    // The single-threaded engine calls the body directly; only the pool pays
+    // for type erasure, once per block
+    if (workerPool)
+    {
+        workerPool->parallelFor(blockCount, task);
+    } else {
+        for (int block = 0; block < blockCount; block++)
+        {
+            task(block);
+        }
+    }
+}
+
+template <typename Phase>
+void Simulation::runCustomerPhase(const Phase& phase)
+{
+    int customerCount = static_cast<int>(customers.size());
+    int blockCount = (customerCount + CustomerBlockSize - 1) / CustomerBlockSize;
+    blockTotals.assign(blockCount, BlockTotals{0, 0, 0, 0.0});
+
+    runBlocks(blockCount, [&](int block)
+        {
+            int end = std::min(customerCount, (block + 1) * CustomerBlockSize);
+            for (int i = block * CustomerBlockSize; i < end; i++)
+            {
+                phase(*customers[i], blockTotals[block]);
+            }
+        });
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Profiler.hpp"
+#include "TimeSeriesRecorder.hpp"
+#include <memory>
+#include <vector>
+
+struct DirectorySnapshot
+{
+    int id;
+    bool processing;
+    int progress;
+    int customerId;
+    int fileId;
+    int fileSize;
+};
+
+struct CustomerSnapshot
+{
+    int id;
+    int pendingFiles;
+    int processedFiles;
+    double totalWaitTime;
+};
+
+struct FileSnapshot
+{
+    int id;
+    int size;
+    double priority;
+    double waitTime;
+};
+
+// Immutable copy of the state the GUI renders, published by the simulation
+// thread at a bounded rate so rendering never touches live engine state.
+struct SimulationSnapshot
+{
+    double elapsedTime;
+    int processedFiles;
+    double totalWaitTime;
+    double requestedSpeed;
+    double achievedSpeed;
+    bool overloaded;
+    int stealCount;
+    double locality;
+    bool completed;
+    std::vector<DirectorySnapshot> directories;
+    // Only filled when customer publishing is enabled
+    std::vector<CustomerSnapshot> customers;
+    // Pending files of the customer selected for details, by index
+    int detailCustomer = -1;
+    std::vector<FileSnapshot> detailFiles;
+    std::vector<PhaseStats> phaseStats;
+    // Shared between snapshots until a new sample is recorded
+    std::shared_ptr<const std::vector<TimeSeriesBucket>> timeSeries;
+};
@@ -0,0 +1,74 @@
+#include "SnapshotClient.hpp"
+
+SnapshotClient::SnapshotClient(QObject* parent)
+    : QObject(parent), socket(new QLocalSocket(this)), connected(false)
+{
+    connect(socket, &QLocalSocket::readyRead, this, &SnapshotClient::readFrames);
+    connect(socket, &QLocalSocket::stateChanged, this, &SnapshotClient::handleStateChange);
+}
+
+void SnapshotClient::attach(const QString& socketPath)
+{
+    detach();
+    decoder.reset();
+    buffer.clear();
+    snapshot.reset();
+    failure.clear();
+    socket->connectToServer(socketPath, QIODevice::ReadOnly);
+}
+
+void SnapshotClient::detach()
+{
+    if (socket->state() != QLocalSocket::UnconnectedState) {
+        failure = "Detached";
+        socket->abort();
+    }
+}
+
+bool SnapshotClient::isAttached() const
+{
+    return connected;
+}
+
+std::shared_ptr<const SimulationSnapshot> SnapshotClient::getSnapshot() const
+{
+    return snapshot;
+}
+
+void SnapshotClient::readFrames()
+{
+    auto bytes = socket->readAll();
+    buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+
+    std::size_t offset = 0;
+    bool applied = false;
+    while (true) {
+        std::size_t consumed = 0;
+        auto status = decoder.decode(buffer.data() + offset, buffer.size() - offset, consumed);
+        if (status == DecodeStatus::NeedMoreData) break;
+        if (status == DecodeStatus::Malformed) {
+            failure = "The server sent a malformed frame";
+            socket->abort();
+            return;
+        }
+        offset += consumed;
+        applied = true;
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+
+    if (applied) {
+        snapshot = std::make_shared<const SimulationSnapshot>(decoder.getState());
+    }
+}
+
+void SnapshotClient::handleStateChange(QLocalSocket::LocalSocketState state)
+{
+    if (state == QLocalSocket::ConnectedState) {
+        connected = true;
+        emit attached();
+    } else if (state == QLocalSocket::UnconnectedState) {
+        // Failed connection attempts end here too, without having attached
+        connected = false;
+        emit detached(failure.isEmpty() ? socket->errorString() : failure);
+    }
+}
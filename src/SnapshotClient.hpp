@@ -0,0 +1,42 @@
+#pragma once
+
+#include "SnapshotProtocol.hpp"
+#include <QLocalSocket>
+#include <QObject>
+#include <QString>
+#include <memory>
+#include <vector>
+
+// Follows a SnapshotServer from the GUI thread. Frames are decoded as they
+// arrive, but a snapshot is only materialised once per read, so a viewer
+// that falls behind renders the newest state rather than every frame.
+class SnapshotClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    SnapshotClient(QObject* parent = nullptr);
+
+    void attach(const QString& socketPath);
+    void detach();
+    bool isAttached() const;
+
+    // Null until the first keyframe has arrived
+    std::shared_ptr<const SimulationSnapshot> getSnapshot() const;
+
+signals:
+    void attached();
+    void detached(const QString& reason);
+
+private slots:
+    void readFrames();
+    void handleStateChange(QLocalSocket::LocalSocketState state);
+
+private:
+    QLocalSocket* socket;
+    SnapshotDecoder decoder;
+    std::vector<unsigned char> buffer;
+    std::shared_ptr<const SimulationSnapshot> snapshot;
+    QString failure;
+    bool connected;
+};
@@ -0,0 +1,324 @@
+#include "SnapshotProtocol.hpp"
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    constexpr char FrameMagic[4] = {'F', 'T', 'S', 'D'};
+
+    // Bounds the entry count a frame may announce, so a corrupt delta
+    // cannot make the decoder allocate without limit
+    constexpr std::int64_t MaxEntries = std::int64_t{1} << 24;
+
+    enum SnapshotFlags : std::uint8_t
+    {
+        Overloaded = 1,
+        Completed = 2
+    };
+
+    class PayloadWriter
+    {
+    public:
+        explicit PayloadWriter(std::vector<unsigned char>& out) : out(out) {}
+
+        void putVarint(std::int64_t value)
+        {
+            auto bits = (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+            while (bits >= 0x80) {
+                out.push_back(static_cast<unsigned char>(bits | 0x80));
+                bits >>= 7;
+            }
+            out.push_back(static_cast<unsigned char>(bits));
+        }
+
+        void putDouble(double value)
+        {
+            unsigned char bytes[sizeof(double)];
+            std::memcpy(bytes, &value, sizeof(double));
+            out.insert(out.end(), bytes, bytes + sizeof(double));
+        }
+
+        void putByte(std::uint8_t value)
+        {
+            out.push_back(value);
+        }
+
+    private:
+        std::vector<unsigned char>& out;
+    };
+
+    class PayloadReader
+    {
+    public:
+        PayloadReader(const unsigned char* data, std::size_t size) : position(data), end(data + size), failed(false) {}
+
+        std::int64_t getVarint()
+        {
+            std::uint64_t bits = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (position == end) {
+                    break;
+                }
+                auto byte = *position++;
+                bits |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) {
+                    return static_cast<std::int64_t>(bits >> 1) ^ -static_cast<std::int64_t>(bits & 1);
+                }
+            }
+            failed = true;
+            return 0;
+        }
+
+        int getInt()
+        {
+            auto value = getVarint();
+            if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max()) {
+                failed = true;
+                return 0;
+            }
+            return static_cast<int>(value);
+        }
+
+        double getDouble()
+        {
+            auto value = 0.0;
+            if (end - position < static_cast<std::ptrdiff_t>(sizeof(double))) {
+                failed = true;
+                return value;
+            }
+            std::memcpy(&value, position, sizeof(double));
+            position += sizeof(double);
+            return value;
+        }
+
+        std::uint8_t getByte()
+        {
+            if (position == end) {
+                failed = true;
+                return 0;
+            }
+            return *position++;
+        }
+
+        bool isValid() const { return !failed; }
+        bool atEnd() const { return position == end; }
+
+    private:
+        const unsigned char* position;
+        const unsigned char* end;
+        bool failed;
+    };
+
+    bool operator==(const DirectorySnapshot& a, const DirectorySnapshot& b)
+    {
+        return a.id == b.id && a.processing == b.processing && a.progress == b.progress
+            && a.customerId == b.customerId && a.fileId == b.fileId && a.fileSize == b.fileSize;
+    }
+
+    bool operator==(const CustomerSnapshot& a, const CustomerSnapshot& b)
+    {
+        return a.id == b.id && a.pendingFiles == b.pendingFiles && a.processedFiles == b.processedFiles
+            && a.totalWaitTime == b.totalWaitTime;
+    }
+
+    void putEntry(PayloadWriter& writer, const DirectorySnapshot& directory)
+    {
+        writer.putVarint(directory.id);
+        writer.putByte(directory.processing ? 1 : 0);
+        writer.putVarint(directory.progress);
+        writer.putVarint(directory.customerId);
+        writer.putVarint(directory.fileId);
+        writer.putVarint(directory.fileSize);
+    }
+
+    void putEntry(PayloadWriter& writer, const CustomerSnapshot& customer)
+    {
+        writer.putVarint(customer.id);
+        writer.putVarint(customer.pendingFiles);
+        writer.putVarint(customer.processedFiles);
+        writer.putDouble(customer.totalWaitTime);
+    }
+
+    void getEntry(PayloadReader& reader, DirectorySnapshot& directory)
+    {
+        directory.id = reader.getInt();
+        directory.processing = reader.getByte() != 0;
+        directory.progress = reader.getInt();
+        directory.customerId = reader.getInt();
+        directory.fileId = reader.getInt();
+        directory.fileSize = reader.getInt();
+    }
+
+    void getEntry(PayloadReader& reader, CustomerSnapshot& customer)
+    {
+        customer.id = reader.getInt();
+        customer.pendingFiles = reader.getInt();
+        customer.processedFiles = reader.getInt();
+        customer.totalWaitTime = reader.getDouble();
+    }
+
+    // Entries at or past the end of previous always count as changed
+    template <typename Entry>
+    void putChanges(PayloadWriter& writer, const std::vector<Entry>& previous, const std::vector<Entry>& next)
+    {
+        auto changed = [&](std::size_t i) { return i >= previous.size() || !(previous[i] == next[i]); };
+
+        std::int64_t changedCount = 0;
+        for (std::size_t i = 0; i < next.size(); i++) {
+            if (changed(i)) changedCount++;
+        }
+
+        writer.putVarint(static_cast<std::int64_t>(next.size()));
+        writer.putVarint(changedCount);
+        std::int64_t last = -1;
+        for (std::size_t i = 0; i < next.size(); i++) {
+            if (!changed(i)) continue;
+            writer.putVarint(static_cast<std::int64_t>(i) - last - 1);
+            putEntry(writer, next[i]);
+            last = static_cast<std::int64_t>(i);
+        }
+    }
+
+    template <typename Entry>
+    bool getChanges(PayloadReader& reader, std::vector<Entry>& entries)
+    {
+        auto count = reader.getVarint();
+        auto changedCount = reader.getVarint();
+        if (!reader.isValid() || count < 0 || count > MaxEntries || changedCount < 0 || changedCount > count) {
+            return false;
+        }
+
+        entries.resize(static_cast<std::size_t>(count));
+        std::int64_t index = -1;
+        for (std::int64_t i = 0; i < changedCount; i++) {
+            auto gap = reader.getVarint();
+            if (!reader.isValid() || gap < 0 || gap >= count - index - 1) {
+                return false;
+            }
+            index += gap + 1;
+            getEntry(reader, entries[static_cast<std::size_t>(index)]);
+        }
+        return reader.isValid();
+    }
+}
+
+SnapshotEncoder::SnapshotEncoder() : keyframeSent(false), sequence(0)
+{
+}
+
+void SnapshotEncoder::encode(const SimulationSnapshot& next, std::vector<unsigned char>& out)
+{
+    auto type = keyframeSent ? FrameType::Delta : FrameType::Keyframe;
+    if (type == FrameType::Keyframe) {
+        directories.clear();
+        customers.clear();
+    }
+
+    auto headerOffset = out.size();
+    out.resize(headerOffset + sizeof(FrameHeader));
+
+    auto writer = PayloadWriter{out};
+    writer.putDouble(next.elapsedTime);
+    writer.putVarint(next.processedFiles);
+    writer.putDouble(next.totalWaitTime);
+    writer.putDouble(next.requestedSpeed);
+    writer.putDouble(next.achievedSpeed);
+    writer.putByte(static_cast<std::uint8_t>((next.overloaded ? Overloaded : 0) | (next.completed ? Completed : 0)));
+    writer.putVarint(next.stealCount);
+    writer.putDouble(next.locality);
+    putChanges(writer, directories, next.directories);
+    putChanges(writer, customers, next.customers);
+
+    auto header = FrameHeader{};
+    std::memcpy(header.magic, FrameMagic, sizeof(FrameMagic));
+    header.type = static_cast<std::uint8_t>(type);
+    header.payloadBytes = static_cast<std::uint32_t>(out.size() - headerOffset - sizeof(FrameHeader));
+    header.sequence = sequence++;
+    std::memcpy(out.data() + headerOffset, &header, sizeof(FrameHeader));
+
+    directories = next.directories;
+    customers = next.customers;
+    keyframeSent = true;
+}
+
+void SnapshotEncoder::reset()
+{
+    keyframeSent = false;
+}
+
+SnapshotDecoder::SnapshotDecoder() : state{}, keyframeSeen(false), sequence(0)
+{
+}
+
+DecodeStatus SnapshotDecoder::decode(const unsigned char* data, std::size_t size, std::size_t& consumed)
+{
+    consumed = 0;
+    if (size < sizeof(FrameHeader)) {
+        return DecodeStatus::NeedMoreData;
+    }
+
+    auto header = FrameHeader{};
+    std::memcpy(&header, data, sizeof(FrameHeader));
+    if (std::memcmp(header.magic, FrameMagic, sizeof(FrameMagic)) != 0 || header.payloadBytes > MaxPayloadBytes) {
+        return DecodeStatus::Malformed;
+    }
+
+    auto type = static_cast<FrameType>(header.type);
+    if (type != FrameType::Keyframe && type != FrameType::Delta) {
+        return DecodeStatus::Malformed;
+    }
+    // A delta only makes sense on top of the frame just before it
+    if (type == FrameType::Delta && (!keyframeSeen || header.sequence != sequence + 1)) {
+        return DecodeStatus::Malformed;
+    }
+
+    if (size - sizeof(FrameHeader) < header.payloadBytes) {
+        return DecodeStatus::NeedMoreData;
+    }
+
+    if (type == FrameType::Keyframe) {
+        state.directories.clear();
+        state.customers.clear();
+    }
+
+    auto reader = PayloadReader{data + sizeof(FrameHeader), header.payloadBytes};
+    state.elapsedTime = reader.getDouble();
+    state.processedFiles = reader.getInt();
+    state.totalWaitTime = reader.getDouble();
+    state.requestedSpeed = reader.getDouble();
+    state.achievedSpeed = reader.getDouble();
+    auto flags = reader.getByte();
+    state.overloaded = (flags & Overloaded) != 0;
+    state.completed = (flags & Completed) != 0;
+    state.stealCount = reader.getInt();
+    state.locality = reader.getDouble();
+    if (!reader.isValid()
+        || !getChanges(reader, state.directories)
+        || !getChanges(reader, state.customers)
+        || !reader.atEnd()) {
+        keyframeSeen = false;
+        return DecodeStatus::Malformed;
+    }
+
+    keyframeSeen = true;
+    sequence = header.sequence;
+    consumed = sizeof(FrameHeader) + header.payloadBytes;
+    return DecodeStatus::FrameApplied;
+}
+
+void SnapshotDecoder::reset()
+{
+    state = SimulationSnapshot{};
+    keyframeSeen = false;
+    sequence = 0;
+}
+
+bool SnapshotDecoder::hasState() const
+{
+    return keyframeSeen;
+}
+
+const SimulationSnapshot& SnapshotDecoder::getState() const
+{
+    return state;
+}
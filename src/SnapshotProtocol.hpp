@@ -0,0 +1,82 @@
+#pragma once
+
+#include "SimulationSnapshot.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Wire format for streaming snapshots to out-of-process viewers.
+//
+// Every frame is a FrameHeader followed by its payload. A keyframe carries
+// the whole snapshot; a delta carries the scalar fields, the current
+// directory and customer counts, and only the entries that changed since
+// the previous frame on the same stream. Integers are zigzag varints and
+// entry indices are stored as gaps from the previous changed entry, so an
+// idle directory costs nothing and a busy one a handful of bytes. Doubles
+// and the header are host layout: both ends share a machine.
+//
+// Phase statistics and the time-series overview are not transmitted.
+struct FrameHeader
+{
+    char magic[4];
+    std::uint8_t type;
+    std::uint8_t reserved[3];
+    std::uint32_t payloadBytes;
+    std::uint32_t sequence;
+};
+
+static_assert(sizeof(FrameHeader) == 16, "frame header layout is part of the wire format");
+
+enum class FrameType : std::uint8_t
+{
+    Keyframe = 1,
+    Delta = 2
+};
+
+// One per stream; remembers what the peer has already been sent.
+class SnapshotEncoder
+{
+public:
+    SnapshotEncoder();
+
+    // Appends one frame describing next to out. The first frame, and the
+    // first after reset(), is a keyframe.
+    void encode(const SimulationSnapshot& next, std::vector<unsigned char>& out);
+    void reset();
+
+private:
+    std::vector<DirectorySnapshot> directories;
+    std::vector<CustomerSnapshot> customers;
+    bool keyframeSent;
+    std::uint32_t sequence;
+};
+
+enum class DecodeStatus
+{
+    NeedMoreData,
+    FrameApplied,
+    Malformed
+};
+
+// Rebuilds snapshots from a byte stream produced by one SnapshotEncoder.
+class SnapshotDecoder
+{
+public:
+    static constexpr std::uint32_t MaxPayloadBytes = 64u << 20;
+
+    SnapshotDecoder();
+
+    // Applies the frame at the start of data, if it is complete. consumed is
+    // the number of bytes used, and is 0 unless a frame was applied. After
+    // Malformed the stream cannot be resumed; reset() and reconnect.
+    DecodeStatus decode(const unsigned char* data, std::size_t size, std::size_t& consumed);
+    void reset();
+
+    bool hasState() const;
+    const SimulationSnapshot& getState() const;
+
+private:
+    SimulationSnapshot state;
+    bool keyframeSeen;
+    std::uint32_t sequence;
+};
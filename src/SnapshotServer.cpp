@@ -0,0 +1,240 @@
+#include "SnapshotServer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    bool acceptsConnections(const sockaddr_un& address)
+    {
+        auto fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return false;
+        }
+        bool connected = ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        ::close(fd);
+        return connected;
+    }
+}
+
+SnapshotServer::SnapshotServer(const Simulation& simulation) :
+    simulation(simulation), listenFd(-1), stopping(false), clientCount(0),
+    connectionCount(0), frameCount(0), bytesSent(0)
+{
+}
+
+SnapshotServer::~SnapshotServer()
+{
+    stop();
+}
+
+bool SnapshotServer::start(const std::string& path, std::string& error)
+{
+    if (listenFd >= 0) {
+        error = "already serving on " + socketPath;
+        return false;
+    }
+
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "socket path is empty or too long: " + path;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    struct stat existing{};
+    if (::lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            error = path + " exists and is not a socket";
+            return false;
+        }
+        if (acceptsConnections(address)) {
+            error = "another server is listening on " + path;
+            return false;
+        }
+        ::unlink(path.c_str());
+    }
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        error = std::string{"cannot create socket: "} + std::strerror(errno);
+        return false;
+    }
+    if (::bind(listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listenFd, 8) != 0) {
+        error = "cannot listen on " + path + ": " + std::strerror(errno);
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    socketPath = path;
+    stopping = false;
+    serverThread = std::thread(&SnapshotServer::serveLoop, this);
+    return true;
+}
+
+void SnapshotServer::stop()
+{
+    stopping = true;
+    if (serverThread.joinable()) {
+        serverThread.join();
+    }
+
+    closeClients();
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        ::unlink(socketPath.c_str());
+    }
+}
+
+bool SnapshotServer::isRunning() const
+{
+    return listenFd >= 0;
+}
+
+int SnapshotServer::getClientCount() const
+{
+    return clientCount;
+}
+
+std::uint64_t SnapshotServer::getConnectionCount() const
+{
+    return connectionCount;
+}
+
+std::uint64_t SnapshotServer::getFrameCount() const
+{
+    return frameCount;
+}
+
+std::uint64_t SnapshotServer::getBytesSent() const
+{
+    return bytesSent;
+}
+
+void SnapshotServer::serveLoop()
+{
+    const auto frameInterval = std::chrono::milliseconds(FrameIntervalMs);
+    auto nextFrame = std::chrono::steady_clock::now();
+    auto pollFds = std::vector<pollfd>{};
+
+    while (!stopping) {
+        pollFds.clear();
+        pollFds.push_back(pollfd{listenFd, POLLIN, 0});
+        for (const auto& client : clients) {
+            short events = POLLIN;
+            if (client->sent < client->pending.size()) events |= POLLOUT;
+            pollFds.push_back(pollfd{client->fd, events, 0});
+        }
+
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextFrame - std::chrono::steady_clock::now());
+        auto timeout = static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, wait.count()));
+        if (::poll(pollFds.data(), pollFds.size(), timeout) < 0 && errno != EINTR) {
+            break;
+        }
+
+        // Existing clients first, while pollFds still lines up with them
+        for (auto i = clients.size(); i-- > 0;) {
+            auto revents = pollFds[i + 1].revents;
+            auto& client = *clients[i];
+            bool alive = (revents & (POLLERR | POLLNVAL)) == 0;
+            if (alive && (revents & (POLLIN | POLLHUP))) alive = drainInput(client);
+            if (alive && (revents & POLLOUT)) alive = flush(client);
+            if (!alive) {
+                ::close(client.fd);
+                clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+        if (pollFds[0].revents & POLLIN) {
+            acceptClients();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= nextFrame) {
+            auto snapshot = simulation.getSnapshot();
+            for (auto i = clients.size(); snapshot && i-- > 0;) {
+                auto& client = *clients[i];
+                if (client.sent < client.pending.size() || client.lastEncoded == snapshot) continue;
+
+                client.pending.clear();
+                client.sent = 0;
+                client.encoder.encode(*snapshot, client.pending);
+                client.lastEncoded = snapshot;
+                frameCount++;
+                if (!flush(client)) {
+                    ::close(client.fd);
+                    clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(i));
+                }
+            }
+
+            // Skip missed frames instead of bursting to catch up
+            nextFrame = std::max(nextFrame + frameInterval, now);
+        }
+        clientCount = static_cast<int>(clients.size());
+    }
+}
+
+void SnapshotServer::acceptClients()
+{
+    while (true) {
+        auto fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        if (clients.size() >= MaxClients) {
+            ::close(fd);
+            continue;
+        }
+
+        auto client = std::make_unique<Client>();
+        client->fd = fd;
+        client->sent = 0;
+        clients.push_back(std::move(client));
+        connectionCount++;
+    }
+}
+
+bool SnapshotServer::drainInput(Client& client)
+{
+    // Viewers have nothing to say; reading only detects that they left
+    unsigned char discard[256];
+    while (true) {
+        auto received = ::recv(client.fd, discard, sizeof(discard), MSG_DONTWAIT);
+        if (received > 0) continue;
+        if (received == 0) return false;
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+}
+
+bool SnapshotServer::flush(Client& client)
+{
+    while (client.sent < client.pending.size()) {
+        auto written = ::send(client.fd, client.pending.data() + client.sent, client.pending.size() - client.sent,
+                              MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        client.sent += static_cast<std::size_t>(written);
+        bytesSent += static_cast<std::uint64_t>(written);
+    }
+    return true;
+}
+
+void SnapshotServer::closeClients()
+{
+    for (const auto& client : clients) {
+        ::close(client->fd);
+    }
+    clients.clear();
+    clientCount = 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "SnapshotProtocol.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Publishes a running simulation's snapshots to viewers over a Unix domain
+// socket.
+//
+// The server thread only reads the snapshot the simulation already
+// publishes, so attaching and detaching viewers never touches the engine.
+// Each client has its own encoder and send buffer. A client still draining
+// its previous frame is skipped rather than queued for, and its next frame
+// is a delta against what it actually received, so a slow viewer sees a
+// lower frame rate instead of growing memory or stalling the others.
+class SnapshotServer
+{
+public:
+    static constexpr int FrameIntervalMs = 16;
+    static constexpr std::size_t MaxClients = 32;
+
+    SnapshotServer(const Simulation& simulation);
+    ~SnapshotServer();
+
+    SnapshotServer(const SnapshotServer&) = delete;
+    SnapshotServer& operator=(const SnapshotServer&) = delete;
+
+    // Replaces a stale socket file left by a server that exited, but not
+    // one that still accepts connections
+    bool start(const std::string& socketPath, std::string& error);
+    void stop();
+    bool isRunning() const;
+
+    int getClientCount() const;
+    std::uint64_t getConnectionCount() const;
+    std::uint64_t getFrameCount() const;
+    std::uint64_t getBytesSent() const;
+
+private:
+    struct Client
+    {
+        int fd;
+        SnapshotEncoder encoder;
+        std::vector<unsigned char> pending;
+        std::size_t sent;
+        std::shared_ptr<const SimulationSnapshot> lastEncoded;
+    };
+
+    void serveLoop();
+    void acceptClients();
+    bool drainInput(Client& client);
+    bool flush(Client& client);
+    void closeClients();
+
+    const Simulation& simulation;
+    std::string socketPath;
+    int listenFd;
+    std::vector<std::unique_ptr<Client>> clients;
+    std::thread serverThread;
+    std::atomic<bool> stopping;
+    std::atomic<int> clientCount;
+    std::atomic<std::uint64_t> connectionCount;
+    std::atomic<std::uint64_t> frameCount;
+    std::atomic<std::uint64_t> bytesSent;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+// Single-producer single-consumer ring laid over caller-provided memory, so
+// the same code works on the heap and in POSIX shared memory between
+// processes. Capacity must be a power of two.
+template <typename T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable_v<T>, "ring slots are copied as raw memory");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ring indices must be lock-free");
+
+public:
+    static std::size_t requiredBytes(std::size_t capacity)
+    {
+        return sizeof(Header) + capacity * sizeof(T);
+    }
+
+    SpscRing(void* memory, std::size_t capacity, bool initialize)
+        : header(static_cast<Header*>(memory)),
+          slots(reinterpret_cast<T*>(static_cast<char*>(memory) + sizeof(Header))),
+          mask(capacity - 1)
+    {
+        if (initialize) {
+            header = new (memory) Header{};
+        }
+    }
+
+    bool tryPush(const T& value)
+    {
+        auto head = header->head.load(std::memory_order_relaxed);
+        auto tail = header->tail.load(std::memory_order_acquire);
+        if (head - tail > mask) {
+            return false;
+        }
+
+        slots[head & mask] = value;
+        header->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value)
+    {
+        auto tail = header->tail.load(std::memory_order_relaxed);
+        auto head = header->head.load(std::memory_order_acquire);
+        if (tail == head) {
+            return false;
+        }
+
+        value = slots[tail & mask];
+        header->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return header->tail.load(std::memory_order_acquire) == header->head.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Header
+    {
+        alignas(64) std::atomic<std::uint64_t> head{0};
+        alignas(64) std::atomic<std::uint64_t> tail{0};
+    };
+
+    Header* header;
+    T* slots;
+    std::uint64_t mask;
+};
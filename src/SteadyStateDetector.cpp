@@ -0,0 +1,151 @@
+#include "SteadyStateDetector.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SteadyStateDetector::SteadyStateDetector()
+{
+    reset(SteadyStateConfig{});
+}
+
+void SteadyStateDetector::reset(const SteadyStateConfig& config)
+{
+    this->config = config;
+    this->config.batchSize = std::max(1, config.batchSize);
+    this->config.minBatches = std::clamp(config.minBatches, 2, MaxBatches / 2);
+
+    batchMeans.clear();
+    batchEndTimes.clear();
+    currentBatchSize = this->config.batchSize;
+    partialSum = 0.0;
+    partialCount = 0;
+    observations = 0;
+    truncatedBatches = 0;
+    mean = 0.0;
+    halfWidth = std::numeric_limits<double>::infinity();
+    converged = false;
+    convergenceTime = 0.0;
+}
+
+void SteadyStateDetector::observe(double waitTime, double time)
+{
+    observations++;
+    partialSum += waitTime;
+    partialCount++;
+    if (partialCount < currentBatchSize) {
+        return;
+    }
+
+    batchMeans.push_back(partialSum / partialCount);
+    batchEndTimes.push_back(time);
+    partialSum = 0.0;
+    partialCount = 0;
+
+    if (static_cast<int>(batchMeans.size()) == MaxBatches) {
+        for (int i = 0; i < MaxBatches / 2; i++) {
+            batchMeans[i] = (batchMeans[2 * i] + batchMeans[2 * i + 1]) / 2.0;
+            batchEndTimes[i] = batchEndTimes[2 * i + 1];
+        }
+        batchMeans.resize(MaxBatches / 2);
+        batchEndTimes.resize(MaxBatches / 2);
+        currentBatchSize *= 2;
+    }
+
+    evaluate();
+}
+
+bool SteadyStateDetector::hasConverged() const
+{
+    return converged;
+}
+
+long long SteadyStateDetector::getObservationCount() const
+{
+    return observations;
+}
+
+long long SteadyStateDetector::getWarmupObservations() const
+{
+    return static_cast<long long>(truncatedBatches) * currentBatchSize;
+}
+
+double SteadyStateDetector::getWarmupTime() const
+{
+    return truncatedBatches > 0 ? batchEndTimes[truncatedBatches - 1] : 0.0;
+}
+
+double SteadyStateDetector::getMean() const
+{
+    return mean;
+}
+
+double SteadyStateDetector::getHalfWidth() const
+{
+    return halfWidth;
+}
+
+double SteadyStateDetector::getRelativePrecision() const
+{
+    return mean > 0.0 ? halfWidth / mean : std::numeric_limits<double>::infinity();
+}
+
+double SteadyStateDetector::getConvergenceTime() const
+{
+    return convergenceTime;
+}
+
+void SteadyStateDetector::evaluate()
+{
+    int count = static_cast<int>(batchMeans.size());
+
+    // Suffix sums make every candidate truncation O(1)
+    auto suffixSum = std::vector<double>(count + 1, 0.0);
+    auto suffixSquares = std::vector<double>(count + 1, 0.0);
+    for (int i = count - 1; i >= 0; i--) {
+        suffixSum[i] = suffixSum[i + 1] + batchMeans[i];
+        suffixSquares[i] = suffixSquares[i + 1] + batchMeans[i] * batchMeans[i];
+    }
+
+    int best = 0;
+    double bestStatistic = std::numeric_limits<double>::infinity();
+    for (int d = 0; d <= count / 2; d++) {
+        double remaining = count - d;
+        double squaredError = suffixSquares[d] - suffixSum[d] * suffixSum[d] / remaining;
+        double statistic = squaredError / (remaining * remaining);
+        if (statistic < bestStatistic) {
+            bestStatistic = statistic;
+            best = d;
+        }
+    }
+
+    truncatedBatches = best;
+    int kept = count - best;
+    mean = suffixSum[best] / kept;
+    if (kept < 2) {
+        halfWidth = std::numeric_limits<double>::infinity();
+        return;
+    }
+
+    double variance = std::max(0.0, (suffixSquares[best] - kept * mean * mean) / (kept - 1));
+    halfWidth = tQuantile975(kept - 1) * std::sqrt(variance / kept);
+
+    if (!converged && kept >= config.minBatches && getRelativePrecision() <= config.relativePrecision) {
+        converged = true;
+        convergenceTime = batchEndTimes.back();
+    }
+}
+
+double SteadyStateDetector::tQuantile975(int degreesOfFreedom)
+{
+    // Two-sided 95% quantiles of Student's t distribution
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086
+    };
+
+    if (degreesOfFreedom <= 0) return 0.0;
+    if (degreesOfFreedom <= 20) return table[degreesOfFreedom - 1];
+    if (degreesOfFreedom <= 30) return 2.080;
+    if (degreesOfFreedom <= 60) return 2.042;
+    return 2.000;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+struct SteadyStateConfig
+{
+    bool enabled = false;
+    // Target half-width of the 95% confidence interval, relative to the mean
+    double relativePrecision = 0.05;
+    int batchSize = 16;
+    int minBatches = 20;
+    bool stopWhenPrecise = true;
+};
+
+// Online estimate of the steady-state mean wait time from the completion
+// series. Completions are grouped into batches; the warm-up is the prefix
+// of batches that minimises the MSER statistic (marginal standard error of
+// what remains), restricted to the first half as MSER requires. The
+// estimate is the mean of the remaining batch means, with a batch-means
+// confidence interval. Batch count is kept bounded by merging neighbouring
+// batches, which doubles the batch size, so memory and the per-batch
+// update cost stay constant however long the run is.
+class SteadyStateDetector
+{
+public:
+    SteadyStateDetector();
+
+    void reset(const SteadyStateConfig& config);
+    void observe(double waitTime, double time);
+
+    bool hasConverged() const;
+    long long getObservationCount() const;
+    // Completions and simulated time discarded as warm-up
+    long long getWarmupObservations() const;
+    double getWarmupTime() const;
+    double getMean() const;
+    double getHalfWidth() const;
+    double getRelativePrecision() const;
+    double getConvergenceTime() const;
+
+private:
+    static constexpr int MaxBatches = 64;
+
+    void evaluate();
+    static double tQuantile975(int degreesOfFreedom);
+
+    SteadyStateConfig config;
+    std::vector<double> batchMeans;
+    std::vector<double> batchEndTimes;
+    int currentBatchSize;
+    double partialSum;
+    int partialCount;
+    long long observations;
+
+    int truncatedBatches;
+    double mean;
+    double halfWidth;
+    bool converged;
+    double convergenceTime;
+};
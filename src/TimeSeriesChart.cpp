@@ -0,0 +1,104 @@
+#include "TimeSeriesChart.hpp"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <algorithm>
+
+TimeSeriesChart::TimeSeriesChart(QWidget* parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(160);
+}
+
+void TimeSeriesChart::setSeries(std::shared_ptr<const std::vector<TimeSeriesBucket>> series)
+{
+    // Snapshots share the series until a new sample lands
+    if (series == this->series) {
+        return;
+    }
+
+    this->series = std::move(series);
+    update();
+}
+
+void TimeSeriesChart::clear()
+{
+    series.reset();
+    update();
+}
+
+void TimeSeriesChart::paintEvent(QPaintEvent*)
+{
+    auto painter = QPainter{this};
+    painter.fillRect(rect(), palette().base());
+
+    int panelWidth = width() / MetricCount;
+    for (int i = 0; i < MetricCount; i++) {
+        auto area = QRect{i * panelWidth, 0, panelWidth, height()}.adjusted(4, 4, -4, -4);
+        paintMetric(painter, area, static_cast<Metric>(i));
+    }
+}
+
+void TimeSeriesChart::paintMetric(QPainter& painter, const QRect& area, Metric metric) const
+{
+    painter.setPen(palette().mid().color());
+    painter.drawRect(area);
+
+    auto titleArea = area.adjusted(4, 2, -4, 0);
+    painter.setPen(palette().text().color());
+    painter.drawText(titleArea, Qt::AlignLeft | Qt::AlignTop, metricName(metric));
+
+    if (!series || series->empty()) {
+        return;
+    }
+
+    int index = static_cast<int>(metric);
+    double low = 0.0;
+    double high = 0.0;
+    for (const auto& bucket : *series) {
+        high = std::max(high, bucket.metrics[index].max);
+    }
+    if (high <= low) high = low + 1.0;
+
+    painter.drawText(titleArea, Qt::AlignRight | Qt::AlignTop, QString::number(series->back().metrics[index].mean(), 'g', 4));
+
+    auto plot = area.adjusted(2, painter.fontMetrics().height() + 4, -2, -2);
+    double startTime = series->front().startTime;
+    double span = std::max(series->back().endTime - startTime, 1e-9);
+
+    auto xFor = [&](double time) {
+        return plot.left() + (time - startTime) / span * plot.width();
+    };
+    auto yFor = [&](double value) {
+        return plot.bottom() - (value - low) / (high - low) * plot.height();
+    };
+
+    auto band = QPainterPath{};
+    auto line = QPainterPath{};
+    for (int i = 0; i < static_cast<int>(series->size()); i++) {
+        const auto& bucket = (*series)[i];
+        double x = xFor((bucket.startTime + bucket.endTime) / 2.0);
+        if (i == 0) {
+            band.moveTo(x, yFor(bucket.metrics[index].max));
+            line.moveTo(x, yFor(bucket.metrics[index].mean()));
+        } else {
+            band.lineTo(x, yFor(bucket.metrics[index].max));
+            line.lineTo(x, yFor(bucket.metrics[index].mean()));
+        }
+    }
+    for (int i = static_cast<int>(series->size()) - 1; i >= 0; i--) {
+        const auto& bucket = (*series)[i];
+        band.lineTo(xFor((bucket.startTime + bucket.endTime) / 2.0), yFor(bucket.metrics[index].min));
+    }
+    band.closeSubpath();
+
+    auto accent = palette().highlight().color();
+    auto bandColor = accent;
+    bandColor.setAlpha(60);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.fillPath(band, bandColor);
+    painter.setPen(QPen(accent, 1.5));
+    painter.drawPath(line);
+    painter.setRenderHint(QPainter::Antialiasing, false);
+}
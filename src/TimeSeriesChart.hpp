@@ -0,0 +1,27 @@
+#pragma once
+
+#include "TimeSeriesRecorder.hpp"
+#include <QWidget>
+#include <memory>
+#include <vector>
+
+// Live small-multiple charts of the recorder's overview series: one panel
+// per metric, with a min/max band behind the mean line.
+class TimeSeriesChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    TimeSeriesChart(QWidget* parent = nullptr);
+
+    void setSeries(std::shared_ptr<const std::vector<TimeSeriesBucket>> series);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    void paintMetric(QPainter& painter, const QRect& area, Metric metric) const;
+
+    std::shared_ptr<const std::vector<TimeSeriesBucket>> series;
+};
@@ -0,0 +1,248 @@
+#include "TimeSeriesRecorder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+const char* metricName(Metric metric)
+{
+    switch (metric) {
+    case Metric::QueueLength: return "queue_length";
+    case Metric::BusyDirectories: return "busy_directories";
+    case Metric::Throughput: return "throughput";
+    case Metric::P99Wait: return "p99_wait";
+    case Metric::Count: break;
+    }
+    return "unknown";
+}
+
+double MetricSummary::mean() const
+{
+    return count > 0 ? sum / count : 0.0;
+}
+
+TimeSeriesRecorder::TimeSeriesRecorder(double sampleInterval)
+    : sampleInterval(sampleInterval)
+{
+    double width = sampleInterval;
+    for (auto& level : levels) {
+        level.width = width;
+        level.ring.resize(BucketsPerLevel);
+        width *= LevelFactor;
+    }
+    reset();
+}
+
+void TimeSeriesRecorder::reset()
+{
+    for (auto& level : levels) {
+        level.head = 0;
+        level.size = 0;
+        level.hasCurrent = false;
+    }
+
+    recentWaitCount = 0;
+    nextRecentWait = 0;
+    nextSampleTime = sampleInterval;
+    lastSampleTime = 0.0;
+    lastProcessedFiles = 0;
+    sampleCount = 0;
+}
+
+void TimeSeriesRecorder::recordCompletion(double waitTime)
+{
+    recentWaits[nextRecentWait] = waitTime;
+    nextRecentWait = (nextRecentWait + 1) % CompletionWindow;
+    recentWaitCount = std::min(recentWaitCount + 1, CompletionWindow);
+}
+
+bool TimeSeriesRecorder::isSampleDue(double time) const
+{
+    // Tolerance for the floating-point drift of repeatedly added ticks
+    return time + 1e-9 >= nextSampleTime;
+}
+
+void TimeSeriesRecorder::sample(double time, int queueLength, int busyDirectories, int processedFiles)
+{
+    double interval = time - lastSampleTime;
+    auto values = std::array<double, MetricCount>{};
+    values[static_cast<int>(Metric::QueueLength)] = queueLength;
+    values[static_cast<int>(Metric::BusyDirectories)] = busyDirectories;
+    values[static_cast<int>(Metric::Throughput)] = interval > 0.0 ? (processedFiles - lastProcessedFiles) / interval : 0.0;
+    values[static_cast<int>(Metric::P99Wait)] = recentWaitPercentile(0.99);
+
+    for (auto& level : levels) {
+        addToLevel(level, time, values);
+    }
+
+    lastSampleTime = time;
+    lastProcessedFiles = processedFiles;
+    nextSampleTime = (std::floor(time / sampleInterval + 1e-9) + 1.0) * sampleInterval;
+    sampleCount++;
+}
+
+void TimeSeriesRecorder::addToLevel(Level& level, double time, const std::array<double, MetricCount>& values)
+{
+    // A sample taken at time t closes the interval (t - width, t]
+    double bucketStart = (std::ceil(time / level.width - 1e-9) - 1.0) * level.width;
+
+    if (level.hasCurrent && level.current.startTime != bucketStart) {
+        level.ring[(level.head + level.size) % BucketsPerLevel] = level.current;
+        if (level.size < BucketsPerLevel) {
+            level.size++;
+        } else {
+            level.head = (level.head + 1) % BucketsPerLevel;
+        }
+        level.hasCurrent = false;
+    }
+
+    if (!level.hasCurrent) {
+        level.current.startTime = bucketStart;
+        level.current.endTime = bucketStart + level.width;
+        for (auto& metric : level.current.metrics) {
+            metric = MetricSummary{std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(), 0.0, 0};
+        }
+        level.hasCurrent = true;
+    }
+
+    for (int i = 0; i < MetricCount; i++) {
+        auto& metric = level.current.metrics[i];
+        metric.min = std::min(metric.min, values[i]);
+        metric.max = std::max(metric.max, values[i]);
+        metric.sum += values[i];
+        metric.count++;
+    }
+}
+
+double TimeSeriesRecorder::recentWaitPercentile(double fraction) const
+{
+    if (recentWaitCount == 0) {
+        return 0.0;
+    }
+
+    auto waits = std::vector<double>(recentWaits.begin(), recentWaits.begin() + recentWaitCount);
+    auto rank = static_cast<std::size_t>(std::ceil(fraction * waits.size()));
+    auto index = std::min(waits.size() - 1, rank > 0 ? rank - 1 : 0);
+    std::nth_element(waits.begin(), waits.begin() + index, waits.end());
+    return waits[index];
+}
+
+std::vector<TimeSeriesBucket> TimeSeriesRecorder::getLevel(int level) const
+{
+    const auto& source = levels[std::clamp(level, 0, LevelCount - 1)];
+    auto buckets = std::vector<TimeSeriesBucket>{};
+    buckets.reserve(source.size + 1);
+    for (int i = 0; i < source.size; i++) {
+        buckets.push_back(source.ring[(source.head + i) % BucketsPerLevel]);
+    }
+    if (source.hasCurrent) {
+        buckets.push_back(source.current);
+    }
+    return buckets;
+}
+
+std::vector<TimeSeriesBucket> TimeSeriesRecorder::getOverview() const
+{
+    for (int level = 0; level < LevelCount; level++) {
+        const auto& candidate = levels[level];
+        if (candidate.size < BucketsPerLevel) {
+            return getLevel(level);
+        }
+    }
+    return getLevel(LevelCount - 1);
+}
+
+int TimeSeriesRecorder::getSampleCount() const
+{
+    return sampleCount;
+}
+
+bool TimeSeriesRecorder::exportCsv(const std::string& path, std::string& error) const
+{
+    auto output = std::ofstream{path, std::ios::trunc};
+    if (!output) {
+        error = "cannot create " + path;
+        return false;
+    }
+
+    output << "level,start_time,end_time";
+    for (int i = 0; i < MetricCount; i++) {
+        auto name = metricName(static_cast<Metric>(i));
+        output << "," << name << "_min," << name << "_mean," << name << "_max";
+    }
+    output << "\n";
+
+    for (int level = 0; level < LevelCount; level++) {
+        for (const auto& bucket : getLevel(level)) {
+            output << level << "," << bucket.startTime << "," << bucket.endTime;
+            for (const auto& metric : bucket.metrics) {
+                output << "," << metric.min << "," << metric.mean() << "," << metric.max;
+            }
+            output << "\n";
+        }
+    }
+
+    if (!output) {
+        error = "failed writing " + path;
+        return false;
+    }
+    return true;
+}
+
+bool TimeSeriesRecorder::exportColumnar(const std::string& path, std::string& error) const
+{
+    auto columnNames = std::vector<std::string>{"level", "start_time", "end_time"};
+    for (int i = 0; i < MetricCount; i++) {
+        auto name = std::string{metricName(static_cast<Metric>(i))};
+        columnNames.push_back(name + "_min");
+        columnNames.push_back(name + "_mean");
+        columnNames.push_back(name + "_max");
+    }
+
+    auto columns = std::vector<std::vector<double>>(columnNames.size());
+    for (int level = 0; level < LevelCount; level++) {
+        for (const auto& bucket : getLevel(level)) {
+            columns[0].push_back(level);
+            columns[1].push_back(bucket.startTime);
+            columns[2].push_back(bucket.endTime);
+            for (int i = 0; i < MetricCount; i++) {
+                columns[3 + i * 3].push_back(bucket.metrics[i].min);
+                columns[4 + i * 3].push_back(bucket.metrics[i].mean());
+                columns[5 + i * 3].push_back(bucket.metrics[i].max);
+            }
+        }
+    }
+
+    auto output = std::ofstream{path, std::ios::binary | std::ios::trunc};
+    if (!output) {
+        error = "cannot create " + path;
+        return false;
+    }
+
+    // Header: magic, column count, row count; then 32-byte column names
+    const char magic[8] = {'F', 'T', 'S', 'C', 'O', 'L', 'S', '1'};
+    auto columnCount = static_cast<std::uint64_t>(columns.size());
+    auto rowCount = static_cast<std::uint64_t>(columns[0].size());
+    output.write(magic, sizeof(magic));
+    output.write(reinterpret_cast<const char*>(&columnCount), sizeof(columnCount));
+    output.write(reinterpret_cast<const char*>(&rowCount), sizeof(rowCount));
+
+    for (const auto& name : columnNames) {
+        char field[32] = {};
+        std::strncpy(field, name.c_str(), sizeof(field) - 1);
+        output.write(field, sizeof(field));
+    }
+
+    for (const auto& column : columns) {
+        output.write(reinterpret_cast<const char*>(column.data()),
+            static_cast<std::streamsize>(column.size() * sizeof(double)));
+    }
+
+    if (!output) {
+        error = "failed writing " + path;
+        return false;
+    }
+    return true;
+}
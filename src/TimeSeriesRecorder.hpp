@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+enum class Metric
+{
+    QueueLength,
+    BusyDirectories,
+    Throughput,
+    P99Wait,
+    Count
+};
+
+constexpr int MetricCount = static_cast<int>(Metric::Count);
+
+const char* metricName(Metric metric);
+
+struct MetricSummary
+{
+    double min;
+    double max;
+    double sum;
+    int count;
+
+    double mean() const;
+};
+
+struct TimeSeriesBucket
+{
+    double startTime;
+    double endTime;
+    std::array<MetricSummary, MetricCount> metrics;
+};
+
+// Records simulation metrics at fixed simulated-time intervals into several
+// resolutions at once. Level k buckets span sampleInterval * LevelFactor^k
+// seconds and each level keeps only its newest BucketsPerLevel buckets, so
+// memory is fixed however long the run is: recent history stays at full
+// resolution, older history survives as min/max/mean summaries.
+class TimeSeriesRecorder
+{
+public:
+    static constexpr int LevelCount = 4;
+    static constexpr int LevelFactor = 8;
+    static constexpr int BucketsPerLevel = 720;
+    static constexpr int CompletionWindow = 1024;
+
+    TimeSeriesRecorder(double sampleInterval = 1.0);
+
+    void reset();
+    void recordCompletion(double waitTime);
+
+    bool isSampleDue(double time) const;
+    void sample(double time, int queueLength, int busyDirectories, int processedFiles);
+
+    // Buckets of one level, oldest first, including the one still filling
+    std::vector<TimeSeriesBucket> getLevel(int level) const;
+    // Finest level that still covers the whole run
+    std::vector<TimeSeriesBucket> getOverview() const;
+    int getSampleCount() const;
+
+    bool exportCsv(const std::string& path, std::string& error) const;
+    // Fixed-width columnar file: a header, a column directory, then each
+    // column's float64 values stored contiguously
+    bool exportColumnar(const std::string& path, std::string& error) const;
+
+private:
+    struct Level
+    {
+        double width;
+        std::vector<TimeSeriesBucket> ring;
+        int head;
+        int size;
+        TimeSeriesBucket current;
+        bool hasCurrent;
+    };
+
+    void addToLevel(Level& level, double time, const std::array<double, MetricCount>& values);
+    double recentWaitPercentile(double fraction) const;
+
+    double sampleInterval;
+    std::array<Level, LevelCount> levels;
+
+    std::array<double, CompletionWindow> recentWaits;
+    int recentWaitCount;
+    int nextRecentWait;
+
+    double nextSampleTime;
+    double lastSampleTime;
+    int lastProcessedFiles;
+    int sampleCount;
+};
@@ -0,0 +1,245 @@
+#include "TraceReplaySource.hpp"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    constexpr char TraceMagic[8] = {'F', 'T', 'S', 'T', 'R', 'A', 'C', 'E'};
+    constexpr std::uint32_t TraceVersion = 1;
+
+    // Pages are returned to the kernel in chunks this large
+    constexpr std::size_t ReleaseChunk = 64 * 1024 * 1024;
+
+    // Customer ids and sizes become ints in the simulation
+    bool parseField(const char*& cursor, std::uint32_t& value)
+    {
+        char* end = nullptr;
+        errno = 0;
+        auto parsed = std::strtoll(cursor, &end, 10);
+        if (end == cursor || errno != 0 || parsed < 0 || parsed > INT_MAX) return false;
+        value = static_cast<std::uint32_t>(parsed);
+        cursor = end;
+        return true;
+    }
+
+    bool parseCsvRow(const std::string& line, TraceRecord& record)
+    {
+        const char* cursor = line.c_str();
+        char* end = nullptr;
+
+        record.timestamp = std::strtod(cursor, &end);
+        if (end == cursor || *end != ',') return false;
+        cursor = end + 1;
+
+        if (!parseField(cursor, record.customerId) || *cursor != ',') return false;
+        cursor++;
+
+        return parseField(cursor, record.size);
+    }
+}
+
+bool convertCsvTrace(const std::string& csvPath, const std::string& tracePath, std::string& error)
+{
+    auto input = std::ifstream{csvPath};
+    if (!input) {
+        error = "cannot open " + csvPath;
+        return false;
+    }
+
+    auto output = std::ofstream{tracePath, std::ios::binary | std::ios::trunc};
+    if (!output) {
+        error = "cannot create " + tracePath;
+        return false;
+    }
+
+    auto header = TraceHeader{};
+    std::memcpy(header.magic, TraceMagic, sizeof(TraceMagic));
+    header.version = TraceVersion;
+    header.recordSize = sizeof(TraceRecord);
+    header.recordCount = 0;
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    auto buffer = std::vector<TraceRecord>{};
+    buffer.reserve(65536);
+    auto flush = [&]() {
+        output.write(reinterpret_cast<const char*>(buffer.data()),
+            static_cast<std::streamsize>(buffer.size() * sizeof(TraceRecord)));
+        buffer.clear();
+    };
+
+    auto line = std::string{};
+    std::uint64_t lineNumber = 0;
+    double lastTimestamp = 0.0;
+    while (std::getline(input, line)) {
+        lineNumber++;
+        if (line.empty()) {
+            continue;
+        }
+
+        auto record = TraceRecord{};
+        if (!parseCsvRow(line, record)) {
+            if (lineNumber == 1) {
+                continue;
+            }
+            error = "malformed row or out-of-range customer id or size at line " + std::to_string(lineNumber);
+            return false;
+        }
+        // Only consecutive records are compared; the first may be negative
+        if (header.recordCount > 0 && record.timestamp < lastTimestamp) {
+            error = "timestamps go backwards at line " + std::to_string(lineNumber);
+            return false;
+        }
+        lastTimestamp = record.timestamp;
+
+        buffer.push_back(record);
+        header.recordCount++;
+        if (buffer.size() == buffer.capacity()) {
+            flush();
+        }
+    }
+    flush();
+
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!output) {
+        error = "failed writing " + tracePath;
+        return false;
+    }
+    return true;
+}
+
+TraceReplaySource::TraceReplaySource()
+    : fd(-1), mapping(nullptr), mappingSize(0), records(nullptr),
+      recordCount(0), cursor(0), releasedBytes(0), origin(0.0)
+{
+}
+
+TraceReplaySource::~TraceReplaySource()
+{
+    close();
+}
+
+bool TraceReplaySource::open(const std::string& path, std::string& error)
+{
+    close();
+
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(TraceHeader)) {
+        error = path + " is not a trace file";
+        close();
+        return false;
+    }
+
+    mappingSize = static_cast<std::size_t>(info.st_size);
+    void* mapped = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        error = "cannot map " + path;
+        mapping = nullptr;
+        close();
+        return false;
+    }
+    mapping = static_cast<char*>(mapped);
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    auto header = reinterpret_cast<const TraceHeader*>(mapping);
+    if (std::memcmp(header->magic, TraceMagic, sizeof(TraceMagic)) != 0 ||
+        header->version != TraceVersion || header->recordSize != sizeof(TraceRecord) ||
+        header->recordCount > (mappingSize - sizeof(TraceHeader)) / sizeof(TraceRecord)) {
+        error = path + " is not a version " + std::to_string(TraceVersion) + " trace file";
+        close();
+        return false;
+    }
+
+    records = reinterpret_cast<const TraceRecord*>(mapping + sizeof(TraceHeader));
+    recordCount = header->recordCount;
+    cursor = 0;
+    releasedBytes = 0;
+    origin = recordCount > 0 ? records[0].timestamp : 0.0;
+    return true;
+}
+
+void TraceReplaySource::close()
+{
+    if (mapping) {
+        munmap(mapping, mappingSize);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+
+    fd = -1;
+    mapping = nullptr;
+    mappingSize = 0;
+    records = nullptr;
+    recordCount = 0;
+    cursor = 0;
+    releasedBytes = 0;
+    origin = 0.0;
+}
+
+void TraceReplaySource::rewind()
+{
+    cursor = 0;
+    releasedBytes = 0;
+}
+
+bool TraceReplaySource::isOpen() const
+{
+    return mapping != nullptr;
+}
+
+bool TraceReplaySource::isExhausted() const
+{
+    return cursor >= recordCount;
+}
+
+std::uint64_t TraceReplaySource::getRecordCount() const
+{
+    return recordCount;
+}
+
+std::uint64_t TraceReplaySource::getReplayedCount() const
+{
+    return cursor;
+}
+
+void TraceReplaySource::advanceTo(double time, const std::function<void(const TraceRecord&)>& sink)
+{
+    while (cursor < recordCount && records[cursor].timestamp - origin <= time) {
+        auto record = records[cursor];
+        record.timestamp -= origin;
+        sink(record);
+        cursor++;
+    }
+
+    releaseConsumedPages();
+}
+
+void TraceReplaySource::releaseConsumedPages()
+{
+    auto consumed = sizeof(TraceHeader) + cursor * sizeof(TraceRecord);
+    if (consumed - releasedBytes < ReleaseChunk) {
+        return;
+    }
+
+    // Clean file-backed pages can simply be dropped; they would be re-read
+    // from disk if touched again
+    auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    auto releaseEnd = consumed / pageSize * pageSize;
+    madvise(mapping + releasedBytes, releaseEnd - releasedBytes, MADV_DONTNEED);
+    releasedBytes = releaseEnd;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Binary transfer trace: a TraceHeader followed by fixed-width TraceRecords
+// sorted by timestamp. Fields are little-endian host layout. Timestamps may
+// use any origin, such as epoch seconds; replay starts at the first record.
+struct TraceHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint64_t recordCount;
+};
+
+struct TraceRecord
+{
+    double timestamp;
+    std::uint32_t customerId;
+    std::uint32_t size;
+};
+
+static_assert(sizeof(TraceHeader) == 24, "trace header layout is part of the file format");
+static_assert(sizeof(TraceRecord) == 16, "trace record layout is part of the file format");
+
+// Converts "timestamp,customer,size" CSV rows (an optional header line is
+// skipped) into the binary trace format. Rows must already be in time order,
+// and customer ids and sizes must fit in an int.
+bool convertCsvTrace(const std::string& csvPath, const std::string& tracePath, std::string& error);
+
+// Streams records out of a memory-mapped trace as simulated time advances.
+// Consumed pages are handed back to the kernel, so resident memory stays
+// bounded no matter how large the trace is.
+class TraceReplaySource
+{
+public:
+    TraceReplaySource();
+    ~TraceReplaySource();
+
+    TraceReplaySource(const TraceReplaySource&) = delete;
+    TraceReplaySource& operator=(const TraceReplaySource&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+    void rewind();
+
+    bool isOpen() const;
+    bool isExhausted() const;
+    std::uint64_t getRecordCount() const;
+    std::uint64_t getReplayedCount() const;
+
+    // Hands every record with timestamp <= time to sink, in order. Times and
+    // the timestamps sink sees are relative to the first record.
+    void advanceTo(double time, const std::function<void(const TraceRecord&)>& sink);
+
+private:
+    void releaseConsumedPages();
+
+    int fd;
+    char* mapping;
+    std::size_t mappingSize;
+    const TraceRecord* records;
+    std::uint64_t recordCount;
+    std::uint64_t cursor;
+    std::size_t releasedBytes;
+    double origin;
+};
@@ -0,0 +1,179 @@
+#include "TransferCalibration.hpp"
+#include "Crc32c.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <new>
+#include <unistd.h>
+
+namespace
+{
+    constexpr std::size_t BlockSize = 1 << 20;
+    constexpr std::size_t BlockAlignment = 4096;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct AlignedDelete
+    {
+        void operator()(unsigned char* block) const
+        {
+            ::operator delete(block, std::align_val_t{BlockAlignment});
+        }
+    };
+
+    using AlignedBlock = std::unique_ptr<unsigned char, AlignedDelete>;
+
+    AlignedBlock allocateBlock()
+    {
+        return AlignedBlock{static_cast<unsigned char*>(::operator new(BlockSize, std::align_val_t{BlockAlignment}))};
+    }
+
+    // Closes and unlinks a scratch file on every exit path
+    struct ScratchFile
+    {
+        int fd = -1;
+        std::string path;
+
+        ~ScratchFile()
+        {
+            if (fd >= 0) ::close(fd);
+            if (!path.empty()) ::unlink(path.c_str());
+        }
+
+        bool create(const std::string& directory, std::string& error)
+        {
+            auto pattern = directory + "/fts-calibration-XXXXXX";
+            fd = ::mkstemp(pattern.data());
+            if (fd < 0) {
+                error = "cannot create scratch file in " + directory + ": " + std::strerror(errno);
+                return false;
+            }
+            path = pattern;
+            return true;
+        }
+
+        // Makes the data durable and drops it from the page cache
+        void evict() const
+        {
+            ::fdatasync(fd);
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        }
+    };
+
+    bool writeFully(int fd, const unsigned char* data, std::size_t size)
+    {
+        while (size > 0) {
+            auto written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    // Short only at end of file
+    std::size_t readFully(int fd, unsigned char* data, std::size_t size)
+    {
+        std::size_t total = 0;
+        while (total < size) {
+            auto count = ::read(fd, data + total, size - total);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                return total;
+            }
+            if (count == 0) break;
+            total += static_cast<std::size_t>(count);
+        }
+        return total;
+    }
+
+    void fillBlock(unsigned char* block, std::uint64_t& state)
+    {
+        // xorshift64: cheap, and incompressible enough for any storage layer
+        for (std::size_t i = 0; i < BlockSize; i += sizeof(state)) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            std::memcpy(block + i, &state, sizeof(state));
+        }
+    }
+
+    double seconds(Clock::time_point start, Clock::time_point end)
+    {
+        return std::max(1e-9, std::chrono::duration<double>(end - start).count());
+    }
+}
+
+bool calibrateTransfer(const std::string& scratchDirectory, std::size_t totalBytes,
+                       TransferCalibration& result, std::string& error)
+{
+    result = TransferCalibration{};
+    result.hardwareChecksum = crc32cHardwareAccelerated();
+
+    std::size_t blockCount = std::max<std::size_t>(1, totalBytes / BlockSize);
+    auto bytes = static_cast<double>(blockCount * BlockSize);
+    auto block = allocateBlock();
+
+    auto source = ScratchFile{};
+    auto copy = ScratchFile{};
+    if (!source.create(scratchDirectory, error) || !copy.create(scratchDirectory, error)) {
+        return false;
+    }
+
+    std::uint32_t sourceChecksum = 0;
+    std::uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (std::size_t i = 0; i < blockCount; i++) {
+        fillBlock(block.get(), state);
+        sourceChecksum = crc32c(sourceChecksum, block.get(), BlockSize);
+        if (!writeFully(source.fd, block.get(), BlockSize)) {
+            error = "cannot write scratch source: " + std::string(std::strerror(errno));
+            return false;
+        }
+    }
+    source.evict();
+
+    // Copy pass: read, write, then make the copy durable
+    ::lseek(source.fd, 0, SEEK_SET);
+    auto copyStart = Clock::now();
+    for (std::size_t i = 0; i < blockCount; i++) {
+        if (readFully(source.fd, block.get(), BlockSize) != BlockSize ||
+            !writeFully(copy.fd, block.get(), BlockSize)) {
+            error = "scratch copy failed: " + std::string(std::strerror(errno));
+            return false;
+        }
+    }
+    ::fdatasync(copy.fd);
+    result.copyBytesPerSecond = bytes / seconds(copyStart, Clock::now());
+    copy.evict();
+
+    // Verify pass: stream the copy back through CRC32C
+    ::lseek(copy.fd, 0, SEEK_SET);
+    std::uint32_t copyChecksum = 0;
+    auto verifyStart = Clock::now();
+    for (std::size_t i = 0; i < blockCount; i++) {
+        if (readFully(copy.fd, block.get(), BlockSize) != BlockSize) {
+            error = "scratch copy is short";
+            return false;
+        }
+        copyChecksum = crc32c(copyChecksum, block.get(), BlockSize);
+    }
+    result.verifyBytesPerSecond = bytes / seconds(verifyStart, Clock::now());
+    result.verified = copyChecksum == sourceChecksum;
+
+    // Checksum alone, over a block already in cache
+    std::uint32_t chained = 0;
+    auto checksumStart = Clock::now();
+    for (std::size_t i = 0; i < blockCount; i++) {
+        chained = crc32c(chained, block.get(), BlockSize);
+    }
+    result.checksumBytesPerSecond = bytes / seconds(checksumStart, Clock::now());
+
+    return true;
+}
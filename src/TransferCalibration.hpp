@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Measured cost of a real local copy and of verifying it with CRC32C, in
+// bytes per second. The copy is made durable before it is timed as done,
+// and both files are evicted from the page cache before verification, so
+// the verify pass streams the copy back from storage.
+struct TransferCalibration
+{
+    double copyBytesPerSecond = 0.0;
+    double verifyBytesPerSecond = 0.0;
+    double checksumBytesPerSecond = 0.0;
+    bool hardwareChecksum = false;
+    bool verified = false;
+};
+
+// Copies totalBytes of generated data through scratch files in
+// scratchDirectory using aligned BlockSize blocks, then verifies the copy
+// against the CRC32C taken while the source was written. The scratch files
+// are removed afterwards.
+bool calibrateTransfer(const std::string& scratchDirectory, std::size_t totalBytes,
+                       TransferCalibration& result, std::string& error);
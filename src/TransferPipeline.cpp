@@ -0,0 +1,308 @@
+#include "TransferPipeline.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace
+{
+    // Guards against float drift leaving a sliver of service time
+    constexpr double ServiceEpsilon = 1e-9;
+}
+
+bool parseStageSpec(const std::string& text, StageSpec& spec, std::string& error)
+{
+    auto fields = std::vector<std::string>{};
+    auto stream = std::istringstream{text};
+    auto field = std::string{};
+    while (std::getline(stream, field, ':')) {
+        fields.push_back(field);
+    }
+
+    if (fields.size() < 2 || fields[0].empty()) {
+        error = "expected name:workers[:policy[:setup[:rate[:buffer[:model]]]]], got \"" + text + "\"";
+        return false;
+    }
+
+    spec = StageSpec{};
+    spec.name = fields[0];
+    spec.workerCount = std::atoi(fields[1].c_str());
+    if (fields.size() > 2) {
+        if (fields[2] == "fifo") {
+            spec.policy = StagePolicy::Fifo;
+        } else if (fields[2] == "smallest") {
+            spec.policy = StagePolicy::SmallestFirst;
+        } else {
+            error = "unknown stage policy \"" + fields[2] + "\" (expected fifo or smallest)";
+            return false;
+        }
+    }
+    if (fields.size() > 3) spec.setupTime = std::atof(fields[3].c_str());
+    if (fields.size() > 4) spec.rate = std::atof(fields[4].c_str());
+    if (fields.size() > 5) spec.bufferCapacity = std::atoi(fields[5].c_str());
+    if (fields.size() > 6) {
+        if (fields[6] == "fixed") {
+            spec.model = ServiceModel::Deterministic;
+        } else if (fields[6] == "exp") {
+            spec.model = ServiceModel::Exponential;
+        } else {
+            error = "unknown service model \"" + fields[6] + "\" (expected fixed or exp)";
+            return false;
+        }
+    }
+
+    if (spec.workerCount < 1 || spec.rate <= 0.0 || spec.setupTime < 0.0 || spec.bufferCapacity < 1) {
+        error = "stage \"" + spec.name + "\" needs workers >= 1, rate > 0, setup >= 0 and buffer >= 1";
+        return false;
+    }
+    return true;
+}
+
+TransferPipeline::TransferPipeline()
+    : entryWorkers(0), entryCompleted(0), entryBusyTime(0.0), entryBlockedTime(0.0),
+      entryQueueIntegral(0.0), entryMaxQueueLength(0)
+{
+}
+
+void TransferPipeline::configure(const PipelineConfig& config, unsigned int seed)
+{
+    stages.clear();
+    for (const auto& spec : config.stages) {
+        auto stage = Stage{};
+        stage.spec = spec;
+        stage.workers.assign(std::max(1, spec.workerCount), Worker{false, false, 0.0, Item{nullptr, 0.0}});
+        stage.completed = 0;
+        stage.busyTime = 0.0;
+        stage.blockedTime = 0.0;
+        stage.queueIntegral = 0.0;
+        stage.maxQueueLength = 0;
+        stage.residenceTotal = 0.0;
+        stages.push_back(std::move(stage));
+    }
+
+    random.seed(seed);
+    latencies.clear();
+    exited.clear();
+    entryWorkers = 0;
+    entryCompleted = 0;
+    entryBusyTime = 0.0;
+    entryBlockedTime = 0.0;
+    entryQueueIntegral = 0.0;
+    entryMaxQueueLength = 0;
+}
+
+void TransferPipeline::clear()
+{
+    // Drops every file in flight; statistics stay until the next configure()
+    for (auto& stage : stages) {
+        stage.buffer.clear();
+        for (auto& worker : stage.workers) {
+            worker = Worker{false, false, 0.0, Item{nullptr, 0.0}};
+        }
+    }
+    exited.clear();
+}
+
+bool TransferPipeline::isEnabled() const
+{
+    return !stages.empty();
+}
+
+bool TransferPipeline::tryAccept(File* file, double now)
+{
+    if (!offer(0, file, now)) {
+        return false;
+    }
+    entryCompleted++;
+    return true;
+}
+
+void TransferPipeline::forceAccept(File* file, double now)
+{
+    if (stages.empty()) {
+        return;
+    }
+
+    stages.front().buffer.push_back(Item{file, now});
+    entryCompleted++;
+}
+
+void TransferPipeline::advance(double now, double deltaTime)
+{
+    for (int index = static_cast<int>(stages.size()) - 1; index >= 0; index--) {
+        auto& stage = stages[index];
+
+        // Each worker uses the whole tick: time left after a file finishes
+        // goes to the next one, or counts as blocked if it cannot hand on
+        for (auto& worker : stage.workers) {
+            double available = deltaTime;
+            while (true) {
+                if (!worker.busy) {
+                    if (stage.buffer.empty()) {
+                        break;
+                    }
+                    worker.item = takeNext(stage);
+                    worker.remaining = serviceTime(stage.spec, *worker.item.file);
+                    worker.busy = true;
+                    worker.blocked = false;
+                }
+
+                if (!worker.blocked) {
+                    double served = std::min(available, worker.remaining);
+                    worker.remaining -= served;
+                    available -= served;
+                    stage.busyTime += served;
+                    if (worker.remaining > ServiceEpsilon) {
+                        break;
+                    }
+                    worker.blocked = true;
+                }
+
+                // Finished: hand on downstream, or stay blocked holding the file
+                double finishTime = now - available;
+                if (!offer(index + 1, worker.item.file, finishTime)) {
+                    stage.blockedTime += available;
+                    break;
+                }
+                stage.completed++;
+                stage.residenceTotal += finishTime - worker.item.stageEnterTime;
+                worker.busy = false;
+                worker.blocked = false;
+            }
+        }
+
+        int queueLength = static_cast<int>(stage.buffer.size());
+        stage.queueIntegral += queueLength * deltaTime;
+        stage.maxQueueLength = std::max(stage.maxQueueLength, queueLength);
+    }
+}
+
+void TransferPipeline::recordEntryStage(int workerCount, int busyCount, int blockedCount, int queueLength, double deltaTime)
+{
+    entryWorkers = workerCount;
+    entryBusyTime += busyCount * deltaTime;
+    entryBlockedTime += blockedCount * deltaTime;
+    entryQueueIntegral += queueLength * deltaTime;
+    entryMaxQueueLength = std::max(entryMaxQueueLength, queueLength);
+}
+
+void TransferPipeline::takeExitedFiles(std::vector<File*>& files)
+{
+    files.insert(files.end(), exited.begin(), exited.end());
+    exited.clear();
+}
+
+bool TransferPipeline::isDrained() const
+{
+    for (const auto& stage : stages) {
+        if (!stage.buffer.empty()) {
+            return false;
+        }
+        for (const auto& worker : stage.workers) {
+            if (worker.busy) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<StageStats> TransferPipeline::getStats(double elapsedTime) const
+{
+    auto stats = std::vector<StageStats>{};
+    if (!isEnabled() || elapsedTime <= 0.0) {
+        return stats;
+    }
+
+    // The directories are the entry stage; their queue is the pending files
+    double entryCapacity = std::max(1, entryWorkers) * elapsedTime;
+    stats.push_back(StageStats{
+        "directories", entryWorkers, entryCompleted,
+        entryCompleted / elapsedTime,
+        entryBusyTime / entryCapacity,
+        entryBlockedTime / entryCapacity,
+        entryQueueIntegral / elapsedTime,
+        entryMaxQueueLength,
+        entryCompleted > 0 ? entryBusyTime / entryCompleted : 0.0
+    });
+
+    for (const auto& stage : stages) {
+        double capacity = stage.workers.size() * elapsedTime;
+        stats.push_back(StageStats{
+            stage.spec.name, static_cast<int>(stage.workers.size()), stage.completed,
+            stage.completed / elapsedTime,
+            stage.busyTime / capacity,
+            stage.blockedTime / capacity,
+            stage.queueIntegral / elapsedTime,
+            stage.maxQueueLength,
+            stage.completed > 0 ? stage.residenceTotal / stage.completed : 0.0
+        });
+    }
+    return stats;
+}
+
+double TransferPipeline::getLatencyPercentile(double fraction) const
+{
+    if (latencies.empty()) {
+        return 0.0;
+    }
+
+    auto sorted = latencies;
+    auto rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+    auto index = std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+double TransferPipeline::getMeanLatency() const
+{
+    if (latencies.empty()) {
+        return 0.0;
+    }
+
+    double total = 0.0;
+    for (double latency : latencies) {
+        total += latency;
+    }
+    return total / latencies.size();
+}
+
+bool TransferPipeline::offer(int stageIndex, File* file, double now)
+{
+    if (stageIndex == static_cast<int>(stages.size())) {
+        file->markExited(now);
+        latencies.push_back(now - file->getEnqueueTime());
+        exited.push_back(file);
+        return true;
+    }
+
+    auto& stage = stages[stageIndex];
+    if (static_cast<int>(stage.buffer.size()) >= stage.spec.bufferCapacity) {
+        return false;
+    }
+    stage.buffer.push_back(Item{file, now});
+    return true;
+}
+
+double TransferPipeline::serviceTime(const StageSpec& spec, const File& file)
+{
+    double mean = spec.setupTime + file.getSize() / spec.rate;
+    if (spec.model == ServiceModel::Exponential && mean > 0.0) {
+        return std::exponential_distribution<double>{1.0 / mean}(random);
+    }
+    return mean;
+}
+
+TransferPipeline::Item TransferPipeline::takeNext(Stage& stage)
+{
+    auto next = stage.buffer.begin();
+    if (stage.spec.policy == StagePolicy::SmallestFirst) {
+        next = std::min_element(stage.buffer.begin(), stage.buffer.end(), [](const Item& a, const Item& b) {
+            return a.file->getSize() < b.file->getSize();
+        });
+    }
+
+    auto item = *next;
+    stage.buffer.erase(next);
+    return item;
+}
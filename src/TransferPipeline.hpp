@@ -0,0 +1,136 @@
+#pragma once
+
+#include "File.hpp"
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+enum class StagePolicy
+{
+    Fifo,
+    SmallestFirst
+};
+
+enum class ServiceModel
+{
+    Deterministic,
+    Exponential
+};
+
+// One stage after the directory transfer. Each of its workers serves one
+// file at a time, taking setupTime + size / rate seconds (the mean, for the
+// exponential model). Its input buffer holds at most bufferCapacity files.
+struct StageSpec
+{
+    std::string name;
+    int workerCount = 1;
+    StagePolicy policy = StagePolicy::Fifo;
+    ServiceModel model = ServiceModel::Deterministic;
+    double setupTime = 0.0;
+    double rate = 10.0;
+    int bufferCapacity = 16;
+};
+
+struct PipelineConfig
+{
+    std::vector<StageSpec> stages;
+};
+
+// Parses "name:workers[:policy[:setup[:rate[:buffer[:model]]]]]", for example
+// "verify:2:fifo:0.2:50:8:exp"
+bool parseStageSpec(const std::string& text, StageSpec& spec, std::string& error);
+
+struct StageStats
+{
+    std::string name;
+    int workerCount;
+    long long completed;
+    double throughput;
+    double utilization;
+    double blockedFraction;
+    double meanQueueLength;
+    int maxQueueLength;
+    double meanResidence;
+};
+
+// Stages that every file passes through, in order, after leaving its
+// directory. A worker that finishes while the next buffer is full keeps the
+// file and stays blocked, so a slow stage backs pressure up the chain and
+// finally into the directories themselves.
+class TransferPipeline
+{
+public:
+    TransferPipeline();
+
+    // Builds the stages and resets statistics
+    void configure(const PipelineConfig& config, unsigned int seed);
+    // Drops files in flight, e.g. before their customers are deleted
+    void clear();
+    bool isEnabled() const;
+
+    // Offers a file that just left its directory; false when the first
+    // buffer is full
+    bool tryAccept(File* file, double now);
+    // Accepts even into a full buffer
+    void forceAccept(File* file, double now);
+
+    // Runs one tick, last stage first so space freed downstream is visible
+    // upstream in the same tick
+    void advance(double now, double deltaTime);
+
+    // Occupancy of the directories that feed the pipeline, for their stats row
+    void recordEntryStage(int workerCount, int busyCount, int blockedCount, int queueLength, double deltaTime);
+
+    // Moves out the files that left the last stage since the previous call
+    void takeExitedFiles(std::vector<File*>& files);
+
+    bool isDrained() const;
+    std::vector<StageStats> getStats(double elapsedTime) const;
+    double getLatencyPercentile(double fraction) const;
+    double getMeanLatency() const;
+
+private:
+    struct Item
+    {
+        File* file;
+        double stageEnterTime;
+    };
+
+    struct Worker
+    {
+        bool busy;
+        bool blocked;
+        double remaining;
+        Item item;
+    };
+
+    struct Stage
+    {
+        StageSpec spec;
+        std::deque<Item> buffer;
+        std::vector<Worker> workers;
+        long long completed;
+        double busyTime;
+        double blockedTime;
+        double queueIntegral;
+        int maxQueueLength;
+        double residenceTotal;
+    };
+
+    bool offer(int stageIndex, File* file, double now);
+    double serviceTime(const StageSpec& spec, const File& file);
+    Item takeNext(Stage& stage);
+
+    std::vector<Stage> stages;
+    std::mt19937 random;
+    std::vector<double> latencies;
+    std::vector<File*> exited;
+
+    int entryWorkers;
+    long long entryCompleted;
+    double entryBusyTime;
+    double entryBlockedTime;
+    double entryQueueIntegral;
+    int entryMaxQueueLength;
+};
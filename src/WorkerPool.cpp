@@ -0,0 +1,108 @@
+#include "WorkerPool.hpp"
+
+WorkerPool::WorkerPool(int threadCount)
+    : currentTask(nullptr), currentBlockCount(0), nextBlock(0),
+      busyWorkers(0), generation(0), stopping(false)
+{
+    for (int i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+int WorkerPool::getThreadCount() const
+{
+    return static_cast<int>(workers.size()) + 1;
+}
+
+void WorkerPool::parallelFor(int blockCount, const std::function<void(int)>& task)
+{
+    if (blockCount <= 0)
+    {
+        return;
+    }
+
+    if (workers.empty() || blockCount == 1)
+    {
+        for (int block = 0; block < blockCount; block++)
+        {
+            task(block);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        currentTask = &task;
+        currentBlockCount = blockCount;
+        nextBlock.store(0, std::memory_order_relaxed);
+        busyWorkers = static_cast<int>(workers.size());
+        generation++;
+    }
+    startCondition.notify_all();
+
+    runBlocks();
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    doneCondition.wait(lock, [this]()
+        {
+            return busyWorkers == 0;
+        });
+    currentTask = nullptr;
+}
+
+void WorkerPool::workerLoop()
+{
+    unsigned long seenGeneration = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            startCondition.wait(lock, [this, seenGeneration]()
+                {
+                    return stopping || generation != seenGeneration;
+                });
+
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+
+        runBlocks();
+
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            busyWorkers--;
+        }
+        doneCondition.notify_one();
+    }
+}
+
+void WorkerPool::runBlocks()
+{
+    // Blocks are claimed dynamically; callers write results per block, so the
+    // outcome does not depend on which thread ran which block.
+    while (true)
+    {
+        int block = nextBlock.fetch_add(1, std::memory_order_relaxed);
+        if (block >= currentBlockCount)
+        {
+            return;
+        }
+        (*currentTask)(block);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool used to fan a tick phase out across cores. The calling
+// thread takes part in every phase, so a pool of N threads spawns N - 1.
+class WorkerPool
+{
+public:
+    WorkerPool(int threadCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int getThreadCount() const;
+
+    // Runs task once for every block in [0, blockCount) and returns when all
+    // of them have finished, which acts as the barrier between phases.
+    void parallelFor(int blockCount, const std::function<void(int)>& task);
+
+private:
+    void workerLoop();
+    void runBlocks();
+
+    std::vector<std::thread> workers;
+    std::mutex poolMutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void(int)>* currentTask;
+    int currentBlockCount;
+    std::atomic<int> nextBlock;
+    int busyWorkers;
+    unsigned long generation;
+    bool stopping;
+};
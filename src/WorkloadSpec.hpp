@@ -0,0 +1,15 @@
+#pragma once
+
+// Shape of the synthetic workload generated at initialize(). Each customer
+// gets a uniform number of files, each of uniform size in KB. With a
+// non-zero repeatProbability each file instead re-sends, with that
+// probability, the content of a file generated earlier (chosen uniformly
+// over all earlier files, so popular content keeps getting more popular).
+struct WorkloadSpec
+{
+    int minFilesPerCustomer = 3;
+    int maxFilesPerCustomer = 10;
+    int minFileSize = 1;
+    int maxFileSize = 100;
+    double repeatProbability = 0.0;
+};
@@ -1,3 +1,4 @@
+#include "HeadlessRunner.hpp"
 #include "MainWindow.hpp"
 
 #include <QApplication>
@@ -6,6 +7,12 @@
 
 int main(int argc, char* argv[])
 {
+    if (HeadlessRunner::isRequested(argc, argv))
+    {
+        auto runner = HeadlessRunner{argc, argv};
+        return runner.run();
+    }
+
     auto app = QApplication{argc, argv};
     app.setStyle("fusion");
 